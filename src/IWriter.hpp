@@ -25,6 +25,9 @@ The development of Pomelo took place at the Friedrich-Alexander University of Er
 #include <vector>
 #include <map>
 #include <cmath>
+#include <fstream>
+#include <iostream>
+#include <string>
 
 #include "duplicationremover.hpp"
 
@@ -75,16 +78,17 @@ public:
 
     void removeduplicates (double epsilon, double xmin, double xmax, double ymin, double ymax, double zmin, double zmax, unsigned int nx = 16, unsigned int ny = 16, unsigned int nz = 16 )
     {
-        std::cout << "IWriter: remove duplicates" << std::endl;
+        if (verbose) std::cout << "IWriter: remove duplicates" << std::endl;
         duplicationremover d(nx, ny, nz);
+        d.verbose = verbose;
         d.setboundaries(xmin, xmax, ymin, ymax, zmin, zmax);
-        std::cout << "\tadding points" << std::endl;
+        if (verbose) std::cout << "\tadding points" << std::endl;
         d.addPoints(p, true);
-        std::cout << "\tremoving duplicates" << std::endl;
+        if (verbose) std::cout << "\tremoving duplicates" << std::endl;
         d.removeduplicates(epsilon);
-        std::cout << "\tget back points" << std::endl;
+        if (verbose) std::cout << "\tget back points" << std::endl;
         d.getallPoints(p);
-        std::cout << "\tmatch back indices" << std::endl;
+        if (verbose) std::cout << "\tmatch back indices" << std::endl;
         rearrangeIndices(d.indexShift);
 
         //std::cout << "\torder indices" << std::endl;
@@ -93,7 +97,7 @@ public:
 
     void orderIndices ()
     {
-        std::cout << "order indices" << std::endl;
+        if (verbose) std::cout << "order indices" << std::endl;
         std::map<unsigned int, long> indexShift;
         unsigned int label = 1;
         for( auto it = p.points.begin(); it != p.points.end(); ++it)
@@ -119,7 +123,7 @@ public:
             //std::cout << i << " " << indexShift[i] << std::endl;
         }
 
-        std::cout << "\tPolywriter rearrange Indices"<< std::endl;
+        if (verbose) std::cout << "\tPolywriter rearrange Indices"<< std::endl;
         unsigned int i = 0;
         double fivepercentSteps = 0.05*static_cast<double>(faces.size());
         double target = fivepercentSteps;
@@ -129,7 +133,7 @@ public:
             if ( i >= target)
             {
                 target += fivepercentSteps;
-                std::cout << static_cast<int>(static_cast<double>(i)/static_cast<double>(faces.size())*100) << " \%\t"<< std::flush;
+                if (verbose) std::cout << static_cast<int>(static_cast<double>(i)/static_cast<double>(faces.size())*100) << " \%\t"<< std::flush;
             } 
             unsigned int j = 0;
             for (auto it2 = it->second.begin(); it2 != it->second.end(); ++it2)
@@ -158,7 +162,7 @@ public:
                 }
             }
         }
-        std::cout << std::endl;
+        if (verbose) std::cout << std::endl;
     }
 
 
@@ -166,6 +170,7 @@ public:
     pointpattern p; // holds all the points
     std::map<unsigned int, unsigned int> faceCellMap;   // first is face id, second is cell id
     std::map<unsigned int, std::vector<unsigned int > > faces;
+    bool verbose = true;    // progress output on std::cout
 private:
     unsigned int currentVertexLabel = 1;
     unsigned int currentFaceLabel = 1;
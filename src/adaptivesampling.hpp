@@ -0,0 +1,184 @@
+/* 
+Copyright 2016 Simon Weis and Philipp Schoenhoefer
+
+This file is part of Pomelo.
+
+Pomelo is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Pomelo is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Pomelo.  If not, see <http://www.gnu.org/licenses/>.
+
+The development of Pomelo took place at the Friedrich-Alexander University of Erlangen and was funded by the German Research Foundation (DFG) Forschergruppe FOR1548 "Geometry and Physics of Spatial Random Systems" (GPSRS). 
+*/
+#ifndef ADAPTIVESAMPLING_H_GUARD_123456
+#define ADAPTIVESAMPLING_H_GUARD_123456
+
+#include <vector>
+#include <array>
+#include <map>
+#include <cmath>
+#include <algorithm>
+#include "vec3.hpp"
+#include "spheresampling.hpp"
+
+// local point spacing of the surface triangulation
+// spacing:   largest allowed distance between neighboring points
+// tolerance: largest allowed distance between the surface and a chord of length h,
+//            for a local radius of curvature rho this is h^2/(8 rho), so h = sqrt(8 rho tolerance)
+// a value of 0 switches the respective criterion off
+class samplingdensity
+{
+public:
+    double spacing;
+    double tolerance;
+
+    samplingdensity () : spacing(0), tolerance(0)
+    {};
+
+    bool active() const
+    {
+        return spacing > 0 || tolerance > 0;
+    };
+
+    // spacing at a point with the (smallest) radius of curvature rho
+    double at(double rho) const
+    {
+        if (tolerance <= 0) return spacing;
+        double h = std::sqrt(8.0 * rho * tolerance);
+        if (spacing > 0 && spacing < h) return spacing;
+        return h;
+    };
+};
+
+// smallest principal radius of curvature of the ellipsoid x^2/a^2 + y^2/b^2 + z^2/c^2 = 1 at the surface point p
+inline double ellipsoidradiusofcurvature(vec3 const& p, double a, double b, double c)
+{
+    double q = std::sqrt(p.x*p.x/(a*a*a*a) + p.y*p.y/(b*b*b*b) + p.z*p.z/(c*c*c*c));
+    double abc2 = a*a*b*b*c*c;
+    double gauss = 1.0/(abc2*q*q*q*q);
+    double mean = (a*a + b*b + c*c - dot(p, p))/(2.0*abc2*q*q*q);
+    double kmax = mean + std::sqrt(std::max(0.0, mean*mean - gauss));
+    return 1.0/kmax;
+}
+
+// greedy thinning of a dense set of candidate points
+// a candidate is kept if no kept point is closer than its local spacing h[i]
+// returns the indices of the kept candidates
+inline std::vector<unsigned int> thinbyspacing(std::vector<vec3> const& candidates, std::vector<double> const& h)
+{
+    std::vector<unsigned int> kept;
+    if (candidates.empty()) return kept;
+
+    double cellsize = *std::max_element(h.begin(), h.end());
+    std::map<std::array<long, 3>, std::vector<unsigned int> > grid;
+    auto cellof = [cellsize](vec3 const& p)
+    {
+        return std::array<long, 3> {{static_cast<long>(std::floor(p.x/cellsize)), static_cast<long>(std::floor(p.y/cellsize)), static_cast<long>(std::floor(p.z/cellsize))}};
+    };
+
+    for (unsigned int i = 0; i != candidates.size(); ++i)
+    {
+        vec3 const& p = candidates[i];
+        double r = h[i];
+        std::array<long, 3> c = cellof(p);
+        bool free = true;
+        for (long dx = -1; dx <= 1 && free; ++dx)
+        for (long dy = -1; dy <= 1 && free; ++dy)
+        for (long dz = -1; dz <= 1 && free; ++dz)
+        {
+            auto it = grid.find(std::array<long, 3> {{c[0]+dx, c[1]+dy, c[2]+dz}});
+            if (it == grid.end()) continue;
+            for (unsigned int j : it->second)
+            {
+                vec3 d = candidates[j] - p;
+                if (dot(d, d) < r*r)
+                {
+                    free = false;
+                    break;
+                }
+            }
+        }
+        if (!free) continue;
+        kept.push_back(i);
+        grid[c].push_back(i);
+    }
+    return kept;
+}
+
+// point of the ellipsoid with semi-axes a, b, c in the direction of the point (u, v) on face f of the cube [-1, 1]^3
+// (faces +x, -x, +y, -y, +z, -z), i.e. the radially projected cube scaled by the semi-axes
+inline vec3 ellipsoidcubepoint(int f, double u, double v, double a, double b, double c)
+{
+    double s = (f % 2 == 0) ? 1.0 : -1.0;
+    vec3 q = (f/2 == 0) ? vec3{s, u, v} : (f/2 == 1) ? vec3{v, s, u} : vec3{u, v, s};
+    q = normalize(q);
+    return vec3{a*q.x, b*q.y, c*q.z};
+}
+
+// points on the ellipsoid with semi-axes a, b, c, the local spacing follows the curvature
+inline std::vector<vec3> adaptiveellipsoid(double a, double b, double c, samplingdensity const& density)
+{
+    // candidates per patch: the faces of the cube are split recursively until the image of a patch on the ellipsoid is
+    // smaller than a quarter of the local spacing, every patch gives one candidate at its center. A patch is only split
+    // along the edges that are too long, so the elongated patches of the long axes stay coarse in the other direction.
+    // The number of candidates follows the number of points, instead of being fine enough for the smallest spacing everywhere
+    struct patch
+    {
+        int f;
+        double u, v;    // lower corner on the cube face
+        double su, sv;  // edge lengths on the cube face
+    };
+    std::vector<patch> open;
+    for (int f = 0; f != 6; ++f)
+    {
+        open.push_back(patch{f, -1, -1, 2, 2});
+    }
+
+    std::vector<vec3> candidates;
+    std::vector<double> h;
+    while (!open.empty())
+    {
+        patch q = open.back();
+        open.pop_back();
+        vec3 corner[4] = {ellipsoidcubepoint(q.f, q.u, q.v, a, b, c), ellipsoidcubepoint(q.f, q.u + q.su, q.v, a, b, c),
+                          ellipsoidcubepoint(q.f, q.u, q.v + q.sv, a, b, c), ellipsoidcubepoint(q.f, q.u + q.su, q.v + q.sv, a, b, c)};
+        vec3 center = ellipsoidcubepoint(q.f, q.u + 0.5*q.su, q.v + 0.5*q.sv, a, b, c);
+        double hcenter = density.at(ellipsoidradiusofcurvature(center, a, b, c));
+        double hpatch = hcenter;
+        for (vec3 const& p : corner)
+        {
+            hpatch = std::min(hpatch, density.at(ellipsoidradiusofcurvature(p, a, b, c)));
+        }
+        bool splitu = std::max((corner[1] - corner[0]).length(), (corner[3] - corner[2]).length()) > 0.25*hpatch;
+        bool splitv = std::max((corner[2] - corner[0]).length(), (corner[3] - corner[1]).length()) > 0.25*hpatch;
+        if (splitu || splitv)
+        {
+            double su = splitu ? 0.5*q.su : q.su;
+            double sv = splitv ? 0.5*q.sv : q.sv;
+            open.push_back(patch{q.f, q.u, q.v, su, sv});
+            if (splitu) open.push_back(patch{q.f, q.u + su, q.v, su, sv});
+            if (splitv) open.push_back(patch{q.f, q.u, q.v + sv, su, sv});
+            if (splitu && splitv) open.push_back(patch{q.f, q.u + su, q.v + sv, su, sv});
+            continue;
+        }
+        candidates.push_back(center);
+        h.push_back(hcenter);
+    }
+
+    std::vector<vec3> points;
+    for (unsigned int i : thinbyspacing(candidates, h))
+    {
+        points.push_back(candidates[i]);
+    }
+    return points;
+}
+
+#endif
@@ -0,0 +1,133 @@
+/* 
+Copyright 2016 Simon Weis and Philipp Schoenhoefer
+
+This file is part of Pomelo.
+
+Pomelo is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Pomelo is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Pomelo.  If not, see <http://www.gnu.org/licenses/>.
+
+The development of Pomelo took place at the Friedrich-Alexander University of Erlangen and was funded by the German Research Foundation (DFG) Forschergruppe FOR1548 "Geometry and Physics of Spatial Random Systems" (GPSRS). 
+*/
+
+// microbenchmark for the shape generation kernels
+// compares the old GenericMatrix (svec/matrix) path with vec3/mat3
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <random>
+#include "GenericMatrix.h"
+#include "vec3.hpp"
+
+template <typename F>
+double measure (F f, unsigned int repetitions)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int r = 0; r != repetitions; ++r)
+    {
+        f();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / repetitions;
+}
+
+int main (int argc, char* argv[])
+{
+    // default size fits into the cache, so the kernels are measured and not the memory bandwidth
+    std::size_t n = 10000;
+    if (argc > 1) n = std::stoul(argv[1]);
+    const unsigned int repetitions = 1000;
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    std::vector<double> x(n), y(n), z(n);
+    for (std::size_t i = 0; i != n; ++i)
+    {
+        x[i] = dist(gen);
+        y[i] = dist(gen);
+        z[i] = dist(gen);
+    }
+    std::vector<double> ox(n), oy(n), oz(n);
+
+    // some rotation matrix and center
+    const double c = std::cos(0.3);
+    const double s = std::sin(0.3);
+    matrix rotate(c, s, 0, -s, c, 0, 0, 0, 1);
+    svec center(1.5, 2.5, 3.5);
+    mat3 r{{c, -s, 0, s, c, 0, 0, 0, 1}};
+    vec3 t{1.5, 2.5, 3.5};
+
+    std::cout << "N = " << n << " points, " << repetitions << " repetitions" << std::endl << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+
+    double tmatrix = measure([&]()
+    {
+        for (std::size_t i = 0; i != n; ++i)
+        {
+            svec p(x[i], y[i], z[i]);
+            p = rotate * p;
+            p = p + center;
+            ox[i] = p.x();
+            oy[i] = p.y();
+            oz[i] = p.z();
+        }
+    }, repetitions);
+    double checkmatrix = ox[n/2] + oy[n/3] + oz[n/4];
+
+    double tvec3 = measure([&]()
+    {
+        for (std::size_t i = 0; i != n; ++i)
+        {
+            vec3 p = r * vec3{x[i], y[i], z[i]} + t;
+            ox[i] = p.x;
+            oy[i] = p.y;
+            oz[i] = p.z;
+        }
+    }, repetitions);
+    double checkvec3 = ox[n/2] + oy[n/3] + oz[n/4];
+
+    std::cout << "rotate + translate" << std::endl;
+    std::cout << "\tsvec/matrix:  " << tmatrix/n << " ns/point" << std::endl;
+    std::cout << "\tvec3/mat3:    " << tvec3/n << " ns/point (x" << tmatrix/tvec3 << ")" << std::endl;
+    if (checkmatrix != checkvec3) std::cerr << "ERROR: results differ" << std::endl;
+
+    double tnormmatrix = measure([&]()
+    {
+        for (std::size_t i = 0; i != n; ++i)
+        {
+            svec p(x[i], y[i], z[i]);
+            p = p * (1.0/p.abs());
+            ox[i] = p.x();
+            oy[i] = p.y();
+            oz[i] = p.z();
+        }
+    }, repetitions);
+
+    double tnormvec3 = measure([&]()
+    {
+        for (std::size_t i = 0; i != n; ++i)
+        {
+            vec3 p = normalize(vec3{x[i], y[i], z[i]});
+            ox[i] = p.x;
+            oy[i] = p.y;
+            oz[i] = p.z;
+        }
+    }, repetitions);
+
+    std::cout << std::endl << "normalize" << std::endl;
+    std::cout << "\tsvec/matrix:  " << tnormmatrix/n << " ns/point" << std::endl;
+    std::cout << "\tvec3:         " << tnormvec3/n << " ns/point (x" << tnormmatrix/tnormvec3 << ")" << std::endl;
+
+    return 0;
+}
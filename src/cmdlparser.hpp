@@ -21,6 +21,7 @@ The development of Pomelo took place at the Friedrich-Alexander University of Er
 
 #pragma once
 #include <string>
+#include <vector>
 #include "splitstring.hpp"
 
 enum eMode
@@ -31,7 +32,13 @@ enum eMode
     TETRA,
     TETRABLUNT,
     ELLIP,
-    SPHCYL
+    SPHCYL,
+    POLYHEDRON,
+    SUPERQ,
+    CLUMP,
+    MESH,
+    IMAGE,
+    PLANAR
 };
 
 class cmdlParser
@@ -42,8 +49,21 @@ public:
     {
         std::cerr << "Commandline parameters not correct .... aborting "  << std::endl;
         std::cerr << std::endl <<  "Use pomelo this way:\n\t./pomelo -mode [MODE] -i [position-file] -o [outputfolder] (-POLY)"  << std::endl;
-        std::cerr <<  "\twith [MODE] being SPHERE, SPHEREPOLY TETRA, TETRABLUNT, ELLIP, SPHCYL"  << std::endl;
+        std::cerr <<  "\twith [MODE] being SPHERE, SPHEREPOLY TETRA, TETRABLUNT, ELLIP, SPHCYL, POLYHEDRON, SUPERQ, CLUMP, MESH, IMAGE, PLANAR (or 2D)"  << std::endl;
         std::cerr <<  "\tPOLY is optional and gives you only cell.poly"  << std::endl;
+        std::cerr <<  "\t-laguerre is optional for SPHERE and SPHEREPOLY and calculates one cell per sphere directly from the centers (radical tessellation for SPHEREPOLY)"  << std::endl;
+        std::cerr <<  "\t-quadrature [directions] is optional for SPHEREPOLY and integrates the set voronoi cells of the spheres over this number of directions instead of triangulating the surfaces"  << std::endl;
+        std::cerr <<  "\t-meshdepth [depth] sets the resolution of the cell surfaces written by -quadrature, no cell surfaces are written for 0 (default)"  << std::endl;
+        std::cerr <<  "\t-voxel [n] is optional and calculates an approximate set voronoi diagram on a voxel grid with n voxels along the longest box edge"  << std::endl;
+        std::cerr <<  "\t-converge [tolerance] is optional and runs a ladder of surface resolutions instead, recommending the cheapest one that is converged within the tolerance"  << std::endl;
+        std::cerr <<  "\t-select [labels] is optional and calculates only the cells of these particles (e.g. 1,5,10-20), the other particles only bound them"  << std::endl;
+        std::cerr <<  "\t-region box [xmin xmax ymin ymax zmin zmax] or -region sphere [x y z r] is optional and calculates only the cells of the particles with their center in this region"  << std::endl;
+        std::cerr <<  "\t-tilt [xy xz yz] is optional and turns the periodic box into a triclinic one with the edges (lx 0 0), (xy ly 0) and (xz yz lz) as in LAMMPS"  << std::endl;
+        std::cerr <<  "\t-locate [probe file] is optional and writes the label of the particle whose set voronoi cell contains every point (x y z per line) of the probe file to locate.dat, no cell is calculated"  << std::endl;
+        std::cerr <<  "\t-trajectory is optional for SPHERE, SPHEREPOLY, ELLIP, SPHCYL, POLYHEDRON and SUPERQ, the input file holds several concatenated frames (or is a pattern like 'frame*.xyz', the only way for the modes other than SPHERE and SPHEREPOLY, whose files hold one frame each) and the cell volumes and face areas of all frames are written with a frame index"  << std::endl;
+        std::cerr <<  "\t-coherent [distance] is optional with -trajectory, one diagram follows the frames and only particles with a surface point that moved further than distance since they were last calculated are recalculated (with their neighbors)"  << std::endl;
+        std::cerr <<  "\t-refresh [n] recalculates the whole diagram every n frames with -coherent, the default is 100 (0: never)"  << std::endl;
+        std::cerr <<  "\t-threads [n] sets the number of frames calculated at the same time with -trajectory (probe points with -locate, distance transform threads with -voxel), the default is the number of cores"  << std::endl;
         std::cerr << std::endl <<  "Or in a generic way:\n\t./pomelo -mode=GENERIC -i [path-to-lua-file] -o [outputfolder]"  << std::endl;
     }
 
@@ -54,10 +74,33 @@ public:
         fileset=false;
         outset=false;
         polyswitch = false;
+        laguerre = false;
+        quadrature = 0;
+        quadratureset = false;
+        meshdepth = 0;
+        voxel = 0;
+        voxelset = false;
         shrink=1;
         shrinkset=false;
         iterations = 1;
         itset=false;
+        converge = 0;
+        convergeset = false;
+        trajectory = false;
+        threads = 0;
+        threadsset = false;
+        coherent = 0;
+        coherentset = false;
+        refresh = 100;
+        refreshset = false;
+        selectset = false;
+        region = "";
+        regionbounds.clear();
+        regionset = false;
+        locate = "";
+        locateset = false;
+        tilt.clear();
+        tiltset = false;
         // loop over all arguments
         for (int i = 1; i != argc; ++i)
         {
@@ -65,8 +108,21 @@ public:
             parseFileName(argc, argv, i);
             parseOut(argc, argv, i);
             parsePoly(argv, i);
+            parseLaguerre(argv, i);
+            parseQuadrature(argc, argv, i);
+            parseMeshDepth(argc, argv, i);
+            parseVoxel(argc, argv, i);
             parseShrink(argc, argv, i);
             parseIterations(argc, argv, i);
+            parseConverge(argc, argv, i);
+            parseTrajectory(argv, i);
+            parseThreads(argc, argv, i);
+            parseCoherent(argc, argv, i);
+            parseRefresh(argc, argv, i);
+            parseSelect(argc, argv, i);
+            parseRegion(argc, argv, i);
+            parseLocate(argc, argv, i);
+            parseTilt(argc, argv, i);
         }
     }
 
@@ -81,6 +137,15 @@ public:
     
     bool polyswitch;
 
+    bool laguerre;
+
+    unsigned int quadrature;
+    bool quadratureset;
+    unsigned int meshdepth;
+
+    unsigned int voxel;
+    bool voxelset;
+
     double shrink;
     bool shrinkset;
 
@@ -88,6 +153,31 @@ public:
     bool itset;
 
 
+    double converge;
+    bool convergeset;
+
+    bool trajectory;
+    unsigned int threads;
+    bool threadsset;
+
+    double coherent;
+    bool coherentset;
+    unsigned int refresh;
+    bool refreshset;
+
+    std::string select;
+    bool selectset;
+    std::string region;
+    std::vector<double> regionbounds;
+    bool regionset;
+
+    std::string locate;
+    bool locateset;
+
+    std::vector<double> tilt;
+    bool tiltset;
+
+
     void sanityCheckParameters()
     {
         if (thisMode == GENERIC)
@@ -97,9 +187,53 @@ public:
         }
         if(shrinkset || itset)
         {
-            if (thisMode != TETRA && thisMode != TETRABLUNT)
-                std::cerr << "WARNING: Parameter clash. shrink and iteration values are only valid for tetrahedra modes (TETRA, TETRABLUNT)" << std::endl;
+            if (thisMode != TETRA && thisMode != TETRABLUNT && thisMode != POLYHEDRON)
+                std::cerr << "WARNING: Parameter clash. shrink and iteration values are only valid for tetrahedra and polyhedra modes (TETRA, TETRABLUNT, POLYHEDRON)" << std::endl;
         }
+        if (laguerre && thisMode != SPHERE && thisMode != SPHEREPOLY)
+            throw std::string ("ERROR: laguerre is only available for SPHERE and SPHEREPOLY");
+        if (laguerre && convergeset)
+            throw std::string ("ERROR: laguerre cannot be combined with converge");
+        if (quadratureset && thisMode != SPHEREPOLY)
+            throw std::string ("ERROR: quadrature is only available for SPHEREPOLY");
+        if (quadratureset && quadrature == 0)
+            throw std::string ("ERROR: quadrature needs a positive number of directions");
+        if (quadratureset && (laguerre || convergeset))
+            throw std::string ("ERROR: quadrature cannot be combined with laguerre or converge");
+        if (voxelset && voxel == 0)
+            throw std::string ("ERROR: voxel needs a positive number of voxels");
+        if (voxelset && thisMode == PLANAR)
+            throw std::string ("ERROR: voxel is not available for PLANAR");
+        if (voxelset && (laguerre || quadratureset || convergeset))
+            throw std::string ("ERROR: voxel cannot be combined with laguerre, quadrature or converge");
+        if (convergeset && converge <= 0)
+            throw std::string ("ERROR: converge tolerance has to be positive");
+        if (convergeset && thisMode != SPHEREPOLY && thisMode != ELLIP && thisMode != SPHCYL && thisMode != TETRA && thisMode != TETRABLUNT && thisMode != POLYHEDRON && thisMode != SUPERQ && thisMode != CLUMP && thisMode != MESH)
+            throw std::string ("ERROR: converge is only available for SPHEREPOLY, ELLIP, SPHCYL, SUPERQ, CLUMP, MESH, TETRA, TETRABLUNT and POLYHEDRON");
+        if (trajectory && thisMode != SPHERE && thisMode != SPHEREPOLY && thisMode != ELLIP && thisMode != SPHCYL && thisMode != POLYHEDRON && thisMode != SUPERQ)
+            throw std::string ("ERROR: trajectory is only available for SPHERE, SPHEREPOLY, ELLIP, SPHCYL, POLYHEDRON and SUPERQ");
+        if (trajectory && (polyswitch || laguerre || quadratureset || voxelset || convergeset))
+            throw std::string ("ERROR: trajectory cannot be combined with poly, laguerre, quadrature, voxel or converge");
+        if (threadsset && !trajectory && !locateset && !voxelset)
+            std::cerr << "WARNING: Parameter clash. threads is only used with trajectory, locate and voxel" << std::endl;
+        if (threadsset && threads == 0)
+            throw std::string ("ERROR: threads has to be positive");
+        if (coherentset && !trajectory)
+            throw std::string ("ERROR: coherent is only available with trajectory");
+        if (coherentset && coherent < 0)
+            throw std::string ("ERROR: coherent distance cannot be negative");
+        if (refreshset && !coherentset)
+            std::cerr << "WARNING: Parameter clash. refresh is only used with coherent" << std::endl;
+        if ((selectset || regionset) && (laguerre || quadratureset || voxelset || convergeset || trajectory || thisMode == PLANAR))
+            throw std::string ("ERROR: select and region cannot be combined with laguerre, quadrature, voxel, converge, trajectory or PLANAR");
+        if (regionset && region == "sphere" && regionbounds[3] <= 0)
+            throw std::string ("ERROR: region sphere needs a positive radius");
+        if (regionset && region == "box" && (regionbounds[1] < regionbounds[0] || regionbounds[3] < regionbounds[2] || regionbounds[5] < regionbounds[4]))
+            throw std::string ("ERROR: region box needs min <= max");
+        if (locateset && (laguerre || quadratureset || voxelset || convergeset || trajectory || selectset || regionset || thisMode == PLANAR))
+            throw std::string ("ERROR: locate cannot be combined with laguerre, quadrature, voxel, converge, trajectory, select, region or PLANAR");
+        if (tiltset && (laguerre || quadratureset || voxelset || convergeset || trajectory || selectset || regionset || locateset || thisMode == PLANAR))
+            throw std::string ("ERROR: tilt cannot be combined with laguerre, quadrature, voxel, converge, trajectory, select, region, locate or PLANAR");
         if (!outset)
             throw std::string ("ERROR: No output folder specified!");
         if (!fileset)
@@ -112,13 +246,161 @@ private:
     void parsePoly(char* argv[], int i)
     {
         std::string a = argv[i]; 
-        if (a.find("-poly") != std::string::npos || a.find("--poly") != std::string::npos || a.find("-POLY") != std::string::npos || a.find("--POLY") != std::string::npos) polyswitch = true;
+        if (a == "-poly" || a == "--poly" || a == "-POLY" || a == "--POLY") polyswitch = true;
+    }
+
+    void parseLaguerre(char* argv[], int i)
+    {
+        std::string a = argv[i]; 
+        if (a == "-laguerre" || a == "--laguerre") laguerre = true;
+    }
+
+    void parseQuadrature(int argc, char* argv[], int& i)
+    {
+        std::string a = argv[i]; 
+        if (a == "-quadrature" || a == "--quadrature")
+        {
+            if (quadratureset) std::cerr << "WARNING: quadrature has aready been set. Overwriting old value" << std::endl;
+            quadratureset = true;
+            if (i == argc -1) throw std::string("cannot parse quadrature");
+            quadrature = std::stoi(argv[i+1]);
+            ++i; 
+        }
+    }
+
+    void parseMeshDepth(int argc, char* argv[], int& i)
+    {
+        std::string a = argv[i]; 
+        if (a == "-meshdepth" || a == "--meshdepth")
+        {
+            if (i == argc -1) throw std::string("cannot parse meshdepth");
+            meshdepth = std::stoi(argv[i+1]);
+            ++i; 
+        }
+    }
+
+    void parseVoxel(int argc, char* argv[], int& i)
+    {
+        std::string a = argv[i]; 
+        if (a == "-voxel" || a == "--voxel")
+        {
+            if (voxelset) std::cerr << "WARNING: voxel has aready been set. Overwriting old value" << std::endl;
+            voxelset = true;
+            if (i == argc -1) throw std::string("cannot parse voxel");
+            voxel = std::stoi(argv[i+1]);
+            ++i; 
+        }
+    }
+
+    void parseTrajectory(char* argv[], int i)
+    {
+        std::string a = argv[i]; 
+        if (a == "-trajectory" || a == "--trajectory") trajectory = true;
+    }
+
+    void parseThreads(int argc, char* argv[], int& i)
+    {
+        std::string a = argv[i]; 
+        if (a == "-threads" || a == "--threads")
+        {
+            if (threadsset) std::cerr << "WARNING: threads has aready been set. Overwriting old value" << std::endl;
+            threadsset = true;
+            if (i == argc -1) throw std::string("cannot parse threads");
+            threads = std::stoi(argv[i+1]);
+            ++i; 
+        }
+    }
+
+    void parseCoherent(int argc, char* argv[], int& i)
+    {
+        std::string a = argv[i]; 
+        if (a == "-coherent" || a == "--coherent")
+        {
+            if (coherentset) std::cerr << "WARNING: coherent has aready been set. Overwriting old value" << std::endl;
+            coherentset = true;
+            if (i == argc -1) throw std::string("cannot parse coherent");
+            coherent = std::stod(argv[i+1]);
+            ++i; 
+        }
+    }
+
+    void parseRefresh(int argc, char* argv[], int& i)
+    {
+        std::string a = argv[i]; 
+        if (a == "-refresh" || a == "--refresh")
+        {
+            if (refreshset) std::cerr << "WARNING: refresh has aready been set. Overwriting old value" << std::endl;
+            refreshset = true;
+            if (i == argc -1) throw std::string("cannot parse refresh");
+            refresh = std::stoi(argv[i+1]);
+            ++i; 
+        }
+    }
+
+    void parseSelect(int argc, char* argv[], int& i)
+    {
+        std::string a = argv[i]; 
+        if (a == "-select" || a == "--select")
+        {
+            if (selectset) std::cerr << "WARNING: select has aready been set. Overwriting old value" << std::endl;
+            selectset = true;
+            if (i == argc -1) throw std::string("cannot parse select");
+            select = argv[i+1];
+            ++i; 
+        }
+    }
+
+    void parseRegion(int argc, char* argv[], int& i)
+    {
+        std::string a = argv[i]; 
+        if (a == "-region" || a == "--region")
+        {
+            if (regionset) std::cerr << "WARNING: region has aready been set. Overwriting old value" << std::endl;
+            regionset = true;
+            if (i == argc -1) throw std::string("cannot parse region");
+            region = argv[i+1];
+            int n = 0;
+            if (region == "box") n = 6;
+            else if (region == "sphere") n = 4;
+            else throw std::string("region has to be box or sphere");
+            if (i + 1 + n >= argc) throw std::string("cannot parse region " + region);
+            regionbounds.clear();
+            for (int k = 0; k != n; ++k) regionbounds.push_back(std::stod(argv[i + 2 + k]));
+            i += 1 + n;
+        }
+    }
+
+    void parseLocate(int argc, char* argv[], int& i)
+    {
+        std::string a = argv[i]; 
+        if (a == "-locate" || a == "--locate")
+        {
+            if (locateset) std::cerr << "WARNING: locate has aready been set. Overwriting old value" << std::endl;
+            locateset = true;
+            if (i == argc -1) throw std::string("cannot parse locate");
+            locate = argv[i+1];
+            ++i; 
+        }
+    }
+
+    void parseTilt(int argc, char* argv[], int& i)
+    {
+        std::string a = argv[i]; 
+        if (a == "-tilt" || a == "--tilt")
+        {
+            if (tiltset) std::cerr << "WARNING: tilt has aready been set. Overwriting old value" << std::endl;
+            tiltset = true;
+            if (i + 3 >= argc) throw std::string("cannot parse tilt");
+            tilt.clear();
+            for (int k = 0; k != 3; ++k) tilt.push_back(std::stod(argv[i + 1 + k]));
+            i += 3;
+        }
     }
 
     void parseShrink(int argc, char* argv[], int& i)
     {
         std::string a = argv[i]; 
-        if (a.find("-shrink") != std::string::npos || a.find("--shrink") != std::string::npos)
+        if (a == "-shrink" || a == "--shrink")
         {
             if (shrinkset) std::cerr << "WARNING: shrink has aready been set. Overwriting old shrink" << std::endl;
             shrinkset = true;
@@ -131,9 +413,9 @@ private:
     void parseIterations(int argc, char* argv[], int& i)
     {
         std::string a = argv[i]; 
-        if (a.find("-iterations") != std::string::npos || a.find("--iterations") != std::string::npos)
+        if (a == "-iterations" || a == "--iterations")
         {
-            if (shrinkset) std::cerr << "WARNING: iterations has aready been set. Overwriting old value" << std::endl;
+            if (itset) std::cerr << "WARNING: iterations has aready been set. Overwriting old value" << std::endl;
             itset = true;
             if (i == argc -1) throw std::string("cannot parse iterations");
             iterations = std::stoi(argv[i+1]);
@@ -141,11 +423,24 @@ private:
         }
     }
 
+    void parseConverge(int argc, char* argv[], int& i)
+    {
+        std::string a = argv[i]; 
+        if (a == "-converge" || a == "--converge")
+        {
+            if (convergeset) std::cerr << "WARNING: converge has aready been set. Overwriting old value" << std::endl;
+            convergeset = true;
+            if (i == argc -1) throw std::string("cannot parse converge");
+            converge = std::stod(argv[i+1]);
+            ++i; 
+        }
+    }
+
 
     void parseOut(int argc, char* argv[], int& i)
     {
         std::string a = argv[i]; 
-        if (a.find("-o") != std::string::npos || a.find("--o") != std::string::npos)
+        if (a == "-o" || a == "--o")
         {
             if (outset) 
             {
@@ -161,7 +456,7 @@ private:
     void parseFileName(int argc, char* argv[], int& i)
     {
         std::string a = argv[i]; 
-        if (a.find("-i") != std::string::npos || a.find("--i") != std::string::npos)
+        if (a == "-i" || a == "--i")
         {
             if (fileset) std::cerr << "WARNING: FileName has aready been set. Overwriting old filename" << std::endl;
             fileset = true;
@@ -174,7 +469,7 @@ private:
     void parseMode(int argc, char* argv[], int& i)
     {
         std::string a = argv[i]; 
-        if (a.find("-mode") != std::string::npos || a.find("--mode") != std::string::npos)
+        if (a == "-mode" || a == "--mode")
         {
             if (modeset) std::cerr << "WARNING: Mode has already been set. Overwriting old mode." << std::endl;
             modeset = true;
@@ -204,6 +499,30 @@ private:
             {
                 thisMode = SPHCYL;
             }
+            else if (mode == "POLYHEDRON" || mode == "POLYHEDRON")
+            {
+                thisMode = POLYHEDRON;
+            }
+            else if (mode == "SUPERQ" || mode == "SUPERQ")
+            {
+                thisMode = SUPERQ;
+            }
+            else if (mode == "CLUMP" || mode == "CLUMP")
+            {
+                thisMode = CLUMP;
+            }
+            else if (mode == "MESH" || mode == "MESH")
+            {
+                thisMode = MESH;
+            }
+            else if (mode == "IMAGE" || mode == "IMAGE")
+            {
+                thisMode = IMAGE;
+            }
+            else if (mode == "PLANAR" || mode == "2D")
+            {
+                thisMode = PLANAR;
+            }
             else if (mode == "GENERIC" || mode == "GENERIC")
             {
 #ifdef USELUA
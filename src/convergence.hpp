@@ -0,0 +1,176 @@
+/* 
+Copyright 2016 Simon Weis and Philipp Schoenhoefer
+
+This file is part of Pomelo.
+
+Pomelo is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Pomelo is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Pomelo.  If not, see <http://www.gnu.org/licenses/>.
+
+The development of Pomelo took place at the Friedrich-Alexander University of Erlangen and was funded by the German Research Foundation (DFG) Forschergruppe FOR1548 "Geometry and Physics of Spatial Random Systems" (GPSRS). 
+*/
+#ifndef CONVERGENCE_H_GUARD_123456
+#define CONVERGENCE_H_GUARD_123456
+
+#include <vector>
+#include <string>
+#include <cmath>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <iterator>
+#include "include.hpp"
+#include "pointpattern.hpp"
+#include "setvoronoi.hpp"
+
+// ladder of surface resolutions from coarse to fine, every level is compared to the previous one
+// all levels share the domain and the set voronoi calculation, so the voro++ container is reused as long as its division does not change
+class convergencestudy
+{
+public:
+    convergencestudy (double t) : tolerance(t), xmin(0), xmax(0), ymin(0), ymax(0), zmin(0), zmax(0), xpbc(false), ypbc(false), zpbc(false)
+    {
+        sv.verbose = false;
+        sv.mesh = false;
+    };
+
+    void setboundaries(double cxmin, double cxmax, double cymin, double cymax, double czmin, double czmax, bool cxpbc, bool cypbc, bool czpbc)
+    {
+        xmin = cxmin; xmax = cxmax;
+        ymin = cymin; ymax = cymax;
+        zmin = czmin; zmax = czmax;
+        xpbc = cxpbc; ypbc = cypbc; zpbc = czpbc;
+    };
+
+    // duplicates in the surface triangulation of the level are removed in place
+    void addlevel(std::string const& description, pointpattern& pp)
+    {
+        sv.removeduplicates(pp, 1e-12, xmin, xmax, ymin, ymax, zmin, zmax);
+
+        level l;
+        l.description = description;
+        l.points = pp.points.size();
+        auto start = std::chrono::steady_clock::now();
+        sv.calculate(pp, xmin, xmax, ymin, ymax, zmin, zmax, xpbc, ypbc, zpbc);
+        l.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        l.volume = sv.volume;
+        l.neighbors.resize(sv.facearea.size());
+        for (size_t i = 0; i != sv.facearea.size(); ++i)
+        {
+            for (auto const& f : sv.facearea[i]) l.neighbors[i].push_back(f.first);     // sorted, facearea is a map
+        }
+        l.change.assign(l.volume.size(), 0);
+        l.gained.assign(l.volume.size(), 0);
+        l.lost.assign(l.volume.size(), 0);
+        l.maxchange = 0;
+        l.meanchange = 0;
+        l.neighborchanges = 0;
+
+        if (!levels.empty())
+        {
+            level const& prev = levels.back();
+            unsigned long particles = 0;
+            for (unsigned int i = 0; i != l.volume.size(); ++i)
+            {
+                double v = l.volume[i];
+                if (v <= 0) continue;
+                double vp = (i < prev.volume.size()) ? prev.volume[i] : 0;
+                double change = std::fabs(v - vp)/v;
+                l.change[i] = change;
+                if (change > l.maxchange) l.maxchange = change;
+                l.meanchange += change;
+                ++particles;
+
+                std::vector<unsigned int> none;
+                std::vector<unsigned int> const& pn = (i < prev.neighbors.size()) ? prev.neighbors[i] : none;
+                std::vector<unsigned int> const& n = l.neighbors[i];
+                std::vector<unsigned int> diff;
+                std::set_difference(n.begin(), n.end(), pn.begin(), pn.end(), std::back_inserter(diff));
+                l.gained[i] = diff.size();
+                diff.clear();
+                std::set_difference(pn.begin(), pn.end(), n.begin(), n.end(), std::back_inserter(diff));
+                l.lost[i] = diff.size();
+                if (pn.size() != n.size()) ++l.neighborchanges;
+            }
+            if (particles > 0) l.meanchange /= static_cast<double>(particles);
+        }
+        levels.push_back(l);
+
+        std::cout << "level " << levels.size()-1 << " (" << description << "): N= " << l.points << " points, " << l.seconds << " s" << std::endl;
+    };
+
+    // cheapest level whose cell volumes do not change by more than the tolerance when going to the next level, -1 if there is none
+    // the neighbor counts are only reported, tiny faces appear and vanish with the resolution even in converged diagrams
+    int recommend() const
+    {
+        for (unsigned int i = 0; i + 1 < levels.size(); ++i)
+        {
+            if (levels[i+1].maxchange <= tolerance) return i;
+        }
+        return -1;
+    };
+
+    friend std::ostream& operator << (std::ostream &f, convergencestudy const& c)
+    {
+        f << "#1_level #2_resolution #3_points #4_seconds #5_max relative volume change #6_mean relative volume change #7_particles with changed number of neighbors\n";
+        for (unsigned int i = 0; i != c.levels.size(); ++i)
+        {
+            level const& l = c.levels[i];
+            f << i << " " << l.description << " " << l.points << " " << l.seconds << " " << std::setprecision(6) << l.maxchange << " " << l.meanchange << " " << l.neighborchanges << "\n";
+        }
+        int r = c.recommend();
+        if (r < 0) f << "# no level converged within a tolerance of " << c.tolerance << "\n";
+        else f << "# recommended: level " << r << " (" << c.levels[r].description << "), volume changes to the next level are within a tolerance of " << c.tolerance << "\n";
+        return f;
+    };
+
+    // per particle changes of every level compared to the previous one, to find the particles that converge slowest
+    void writeparticles(std::ostream& f) const
+    {
+        f << "#1_level #2_particle label #3_set voronoi cell volume #4_relative volume change #5_number of neighbors #6_neighbors gained #7_neighbors lost\n";
+        f << std::setprecision(12);
+        for (unsigned int k = 1; k < levels.size(); ++k)
+        {
+            level const& l = levels[k];
+            for (unsigned int i = 0; i != l.volume.size(); ++i)
+            {
+                if (l.volume[i] <= 0) continue;
+                f << k << " " << i << " " << l.volume[i] << " " << l.change[i] << " " << l.neighbors[i].size() << " " << l.gained[i] << " " << l.lost[i] << "\n";
+            }
+        }
+    };
+
+    double tolerance;
+
+private:
+    struct level
+    {
+        std::string description;
+        unsigned long points;
+        double seconds;
+        std::vector<double> volume;         // by particle label
+        std::vector<std::vector<unsigned int> > neighbors;  // sorted labels of the neighboring set voronoi cells by particle label
+        std::vector<double> change;         // relative volume change by particle label, compared to the previous level
+        std::vector<unsigned long> gained;  // neighbors by particle label that the previous level does not have
+        std::vector<unsigned long> lost;    // neighbors by particle label of the previous level that are gone
+        double maxchange;           // compared to the previous level
+        double meanchange;
+        unsigned long neighborchanges;
+    };
+    std::vector<level> levels;
+    setvoronoi sv;
+    double xmin, xmax, ymin, ymax, zmin, zmax;
+    bool xpbc, ypbc, zpbc;
+};
+
+#endif
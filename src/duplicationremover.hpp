@@ -27,7 +27,7 @@ The development of Pomelo took place at the Friedrich-Alexander University of Er
 class duplicationremover
 {
 public:
-    duplicationremover(unsigned int _x, unsigned int _y, unsigned int _z) : x(_x), y(_y), z(_z)
+    duplicationremover(unsigned int _x, unsigned int _y, unsigned int _z) : verbose(true), x(_x), y(_y), z(_z)
     {
         list.resize(x*y*z);
     };
@@ -35,7 +35,7 @@ public:
     // read points from a pointpattern
     void addPoints ( pointpattern& porig, bool useCellIDs = false)
     {
-        std::cout << "\tadding N= " <<porig.points.size() <<  " points for duplication check" << std::endl;
+        if (verbose) std::cout << "\tadding N= " <<porig.points.size() <<  " points for duplication check" << std::endl;
         for (  auto it = porig.points.begin();
                 it != porig.points.end();
                 ++it)
@@ -140,7 +140,7 @@ public:
     // remove any duplicated points
     void removeduplicates(double epsilon)
     {
-        std::cout << "\tremoving duplicates within one box" << std::endl;
+        if (verbose) std::cout << "\tremoving duplicates within one box" << std::endl;
         for (
             auto it = list.begin();
             it != list.end();
@@ -149,7 +149,7 @@ public:
             (*it).removeduplicates(epsilon);
         }
 
-        std::cout << "\tremoving duplicates between neighboring boxes" << std::endl;
+        if (verbose) std::cout << "\tremoving duplicates between neighboring boxes" << std::endl;
         for (unsigned int cx = 0; cx != x; ++cx)
             for (unsigned int cy = 0; cy != y; ++cy)
                 for (unsigned int cz = 0; cz != z; ++cz)
@@ -173,7 +173,7 @@ public:
 
                 }
 
-        std::cout << "\tfixing index shifts" << std::endl;
+        if (verbose) std::cout << "\tfixing index shifts" << std::endl;
         for (
             auto it = list.begin();
             it != list.end();
@@ -194,6 +194,7 @@ public:
     }
 
     std::map<unsigned int, long> indexShift;
+    bool verbose;   // progress output on std::cout
 
 
 private:
@@ -0,0 +1,150 @@
+/* 
+Copyright 2016 Simon Weis and Philipp Schoenhoefer
+
+This file is part of Pomelo.
+
+Pomelo is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Pomelo is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Pomelo.  If not, see <http://www.gnu.org/licenses/>.
+
+The development of Pomelo took place at the Friedrich-Alexander University of Erlangen and was funded by the German Research Foundation (DFG) Forschergruppe FOR1548 "Geometry and Physics of Spatial Random Systems" (GPSRS). 
+*/
+#ifndef LAGUERRE_H_GUARD_123456
+#define LAGUERRE_H_GUARD_123456
+
+#include <vector>
+#include <map>
+#include <string>
+#include <iostream>
+#include "include.hpp"
+#include "pointpattern.hpp"
+#include "writerpoly.hpp"
+
+// fast path for spheres: one voronoi cell per particle, calculated directly from the centers
+// without radii this is the point voronoi diagram of the centers (the set voronoi diagram of monodisperse spheres),
+// with radii it is the radical (laguerre) tessellation, an approximation of the set voronoi diagram of polydisperse spheres
+class laguerre
+{
+public:
+    int nx, ny, nz;             // subdivision of the voro++ container
+    std::string customfile;     // if set, voro++ writes id, number of faces and volume of every cell to this file
+    std::vector<double> volume; // by particle label
+    std::vector<std::map<unsigned int, double> > facearea; // by particle label, area of the face to every neighbor label
+
+    laguerre () : nx(0), ny(0), nz(0), customfile("")
+    {};
+
+    // centers holds one point per particle, labeled with the particle label. radii is either empty or holds the radius of every center
+    void calculate(pointpattern const& centers, std::vector<double> const& radii, double xmin, double xmax, double ymin, double ymax, double zmin, double zmax, bool xpbc, bool ypbc, bool zpbc, writerpoly& pw)
+    {
+        using namespace voro;
+        if (!radii.empty() && radii.size() != centers.points.size())
+        {
+            throw std::string("laguerre: number of radii does not match the number of particles");
+        }
+
+        unsigned int maxlabel = 0;
+        for (point const& p : centers.points)
+        {
+            if (static_cast<unsigned int>(p.l) > maxlabel) maxlabel = p.l;
+        }
+        volume.assign(maxlabel+1, 0);
+        facearea.assign(maxlabel+1, std::map<unsigned int, double>());
+
+        if (radii.empty())
+        {
+            pre_container pcon(xmin, xmax, ymin, ymax, zmin, zmax, xpbc, ypbc, zpbc);
+            for (unsigned long id = 0; id != centers.points.size(); ++id)
+            {
+                point const& p = centers.points[id];
+                pcon.put(id, p.x, p.y, p.z);
+            }
+            pcon.guess_optimal(nx, ny, nz);
+            container con(xmin, xmax, ymin, ymax, zmin, zmax, nx, ny, nz, xpbc, ypbc, zpbc, 8);
+            pcon.setup(con);
+            cells(con, centers, pw);
+        }
+        else
+        {
+            pre_container_poly pcon(xmin, xmax, ymin, ymax, zmin, zmax, xpbc, ypbc, zpbc);
+            for (unsigned long id = 0; id != centers.points.size(); ++id)
+            {
+                point const& p = centers.points[id];
+                pcon.put(id, p.x, p.y, p.z, radii[id]);
+            }
+            pcon.guess_optimal(nx, ny, nz);
+            container_poly con(xmin, xmax, ymin, ymax, zmin, zmax, nx, ny, nz, xpbc, ypbc, zpbc, 8);
+            pcon.setup(con);
+            cells(con, centers, pw);
+        }
+        std::cout << "calculated " << centers.points.size() << " cells" << std::endl;
+    };
+
+private:
+    template <typename C> void cells(C& con, pointpattern const& centers, writerpoly& pw)
+    {
+        using namespace voro;
+        if (!customfile.empty()) con.print_custom("%i %s %v", customfile.c_str());
+        c_loop_all cla(con);
+        if(cla.start()) do
+        {
+            voronoicell_neighbor c;
+            if(!con.compute_cell(c, cla)) continue;
+            double xc, yc, zc;
+            cla.pos(xc, yc, zc);
+            unsigned int l = centers.points[cla.pid()].l;
+            volume[l] += c.volume();
+
+            // faces to other particles, negative ids are walls
+            std::vector<int> w;
+            c.neighbors(w);
+            std::vector<double> a;
+            c.face_areas(a);
+            for (unsigned long k = 0; k != w.size(); ++k)
+            {
+                if (w[k] < 0) continue;
+                unsigned int n = centers.points[w[k]].l;
+                if (n != l) facearea[l][n] += a[k];
+            }
+
+            std::vector<int> f;     // face vertices (bracketed, as ID)
+            c.face_vertices(f);
+            std::vector<double> vertices;
+            c.vertices(xc, yc, zc, vertices);
+
+            // the cell is stored around the center as given in the input, so no periodic shift is needed
+            point const& p = centers.points[cla.pid()];
+            double sx = p.x - xc;
+            double sy = p.y - yc;
+            double sz = p.z - zc;
+
+            unsigned long index = 0;
+            while (index < f.size())
+            {
+                unsigned long n = f[index];
+                std::vector<double> positionlist;
+                for (unsigned long k = 1; k <= n; ++k)
+                {
+                    unsigned long v = f[index + k];
+                    positionlist.push_back(vertices[v*3] + sx);
+                    positionlist.push_back(vertices[v*3+1] + sy);
+                    positionlist.push_back(vertices[v*3+2] + sz);
+                }
+                pw.addface(positionlist, l);
+                index += n + 1;
+            }
+        }
+        while (cla.inc());
+    };
+};
+
+#endif
@@ -0,0 +1,928 @@
+/* 
+Copyright 2016 Simon Weis and Philipp Schoenhoefer
+
+This file is part of Pomelo.
+
+Pomelo is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Pomelo is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Pomelo.  If not, see <http://www.gnu.org/licenses/>.
+
+The development of Pomelo took place at the Friedrich-Alexander University of Erlangen and was funded by the German Research Foundation (DFG) Forschergruppe FOR1548 "Geometry and Physics of Spatial Random Systems" (GPSRS). 
+*/
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <memory>
+#include <set>
+#include "libpomelo.hpp"
+#include "pomelo.h"
+#include "setvoronoi.hpp"
+#include "voronoi2d.hpp"
+#include "locator.hpp"
+#include "spheresampling.hpp"
+#include "vec3.hpp"
+
+struct pomeloworkspace::state
+{
+    pointpattern pp;
+    setvoronoi sv;
+    std::map<unsigned int, std::vector<vec3> > spheres;    // unit spheres by number of points
+
+    state ()
+    {
+        sv.verbose = false;
+    };
+};
+
+pomeloworkspace::pomeloworkspace() : s(new state)
+{
+}
+
+pomeloworkspace::~pomeloworkspace()
+{
+    delete s;
+}
+
+namespace
+{
+    // the workspace of the caller or a temporary one
+    struct usestate
+    {
+        pomeloworkspace::state* s;
+        std::unique_ptr<pomeloworkspace::state> temporary;
+
+        explicit usestate(pomeloworkspace* w)
+        {
+            if (w != nullptr)
+            {
+                s = w->s;
+            }
+            else
+            {
+                temporary.reset(new pomeloworkspace::state);
+                s = temporary.get();
+            }
+            s->pp.points.clear();
+        };
+    };
+
+    // neighbors and face areas in compressed sparse row layout
+    void setneighbors(std::vector<std::map<unsigned int, double> > const& facearea, pomeloresult& result)
+    {
+        result.neighboroffset.assign(1, 0);
+        result.neighbor.clear();
+        result.facearea.clear();
+        for (auto const& f : facearea)
+        {
+            for (auto const& n : f)
+            {
+                result.neighbor.push_back(n.first);
+                result.facearea.push_back(n.second);
+            }
+            result.neighboroffset.push_back(result.neighbor.size());
+        }
+    }
+
+    void clearmesh(pomeloresult& result)
+    {
+        result.vertex.clear();
+        result.faceoffset.assign(1, 0);
+        result.faceindex.clear();
+        result.facelabel.clear();
+    }
+
+    void clearpoints(pomeloresult& result)
+    {
+        result.point.clear();
+        result.pointlabel.clear();
+        result.pointfaces.clear();
+        result.pointvolume.clear();
+    }
+
+    void checkbox(pomelobox const& box, bool planar)
+    {
+        if (!(box.xmax > box.xmin) || !(box.ymax > box.ymin) || (!planar && !(box.zmax > box.zmin)))
+            throw std::string("pomelo: empty box");
+    }
+
+    // the points carry label + 1, since the duplicate removal of pomelo reserves label 0
+    void calculate(pomeloworkspace::state& w, pomelobox const& box, pomelooptions const& options, pomeloresult& result)
+    {
+        checkbox(box, false);
+        pointpattern& pp = w.pp;
+        if (pp.points.empty()) throw std::string("pomelo: no surface points");
+        setvoronoi& sv = w.sv;
+        sv.verbose = options.verbose;
+        sv.mesh = options.mesh;
+        sv.cells = options.cells;
+        sv.selection.clear();
+        for (int l : options.selected)
+        {
+            if (l < 0 || l == std::numeric_limits<int>::max()) throw std::string("pomelo: selected label out of range");
+            if (sv.selection.size() < static_cast<size_t>(l) + 2) sv.selection.resize(static_cast<size_t>(l) + 2, false);
+            sv.selection[l + 1] = true;
+        }
+        sv.triclinic = options.triclinic;
+        sv.xy = options.triclinic ? options.xy : 0;
+        sv.xz = options.triclinic ? options.xz : 0;
+        sv.yz = options.triclinic ? options.yz : 0;
+        // the grids for the duplicate removal span the bounding box of a triclinic box
+        double const xmin = box.xmin + std::min(0.0, sv.xy) + std::min(0.0, sv.xz);
+        double const xmax = box.xmax + std::max(0.0, sv.xy) + std::max(0.0, sv.xz);
+        double const ymin = box.ymin + std::min(0.0, sv.yz);
+        double const ymax = box.ymax + std::max(0.0, sv.yz);
+        sv.removeduplicates(pp, options.epsilon, xmin, xmax, ymin, ymax, box.zmin, box.zmax);
+        sv.calculate(pp, box.xmin, box.xmax, box.ymin, box.ymax, box.zmin, box.zmax, box.xpbc, box.ypbc, box.zpbc);
+
+        result.volume.assign(sv.volume.begin() + 1, sv.volume.end());
+        setneighbors(std::vector<std::map<unsigned int, double> >(sv.facearea.begin() + 1, sv.facearea.end()), result);
+        for (unsigned int& n : result.neighbor) --n;
+        clearpoints(result);
+        if (options.cells)
+        {
+            result.point.reserve(3*pp.points.size());
+            result.pointlabel.reserve(pp.points.size());
+            for (point const& p : pp.points)
+            {
+                result.point.push_back(p.x);
+                result.point.push_back(p.y);
+                result.point.push_back(p.z);
+                result.pointlabel.push_back(p.l - 1);
+            }
+            result.pointfaces = sv.cellfaces;
+            result.pointvolume = sv.cellvolume;
+        }
+        clearmesh(result);
+        if (!options.mesh || sv.vertices == 0) return;
+
+        // the same vertices and faces as in cell.poly: shared vertices are merged, repeated vertices of a face are
+        // dropped and faces with less than three vertices are removed
+        sv.pw.verbose = options.verbose;
+        sv.pw.removeduplicates(options.epsilon, xmin, xmax, ymin, ymax, box.zmin, box.zmax, sv.nx, sv.ny, sv.nz);
+        result.vertex.reserve(3*sv.pw.p.points.size());
+        for (point const& p : sv.pw.p.points)
+        {
+            result.vertex.push_back(p.x);
+            result.vertex.push_back(p.y);
+            result.vertex.push_back(p.z);
+        }
+        for (auto const& f : sv.pw.faces)
+        {
+            std::vector<unsigned long> face;
+            for (auto it = f.second.rbegin(); it != f.second.rend(); ++it)
+            {
+                unsigned long index = *it - 1;
+                if (std::find(face.begin(), face.end(), index) == face.end()) face.push_back(index);
+            }
+            if (face.size() < 3) continue;
+            result.faceindex.insert(result.faceindex.end(), face.begin(), face.end());
+            result.faceoffset.push_back(result.faceindex.size());
+            result.facelabel.push_back(sv.pw.faceCellMap.at(f.first) - 1);
+        }
+    }
+}
+
+void pomelocalculate(std::vector<double> const& xyz, std::vector<int> const& labels, pomelobox const& box, pomelooptions const& options, pomeloresult& result, pomeloworkspace* workspace)
+{
+    if (xyz.size() != 3*labels.size()) throw std::string("pomelo: xyz needs three coordinates per label");
+    usestate w(workspace);
+    pointpattern& pp = w.s->pp;
+    pp.points.reserve(labels.size());
+    for (size_t i = 0; i != labels.size(); ++i)
+    {
+        if (labels[i] < 0 || labels[i] == std::numeric_limits<int>::max()) throw std::string("pomelo: label out of range");
+        pp.addpoint(labels[i] + 1, xyz[3*i], xyz[3*i + 1], xyz[3*i + 2]);
+    }
+    calculate(*w.s, box, options, result);
+}
+
+void pomelospheres(std::vector<double> const& xyz, std::vector<double> const& radii, double spacing, double shrink, pomelobox const& box, pomelooptions const& options, pomeloresult& result, pomeloworkspace* workspace)
+{
+    if (xyz.size() != 3*radii.size()) throw std::string("pomelo: xyz needs three coordinates per radius");
+    if (spacing <= 0) throw std::string("pomelo: spacing has to be positive");
+    usestate w(workspace);
+    pointpattern& pp = w.s->pp;
+    for (size_t i = 0; i != radii.size(); ++i)
+    {
+        double r = radii[i] - shrink;
+        if (r <= 0) throw std::string("pomelo: shrink is larger than a radius");
+        vec3 c{xyz[3*i], xyz[3*i + 1], xyz[3*i + 2]};
+        unsigned int n = pointsforspacing(4.0*M_PI*r*r, spacing);
+        auto it = w.s->spheres.find(n);
+        if (it == w.s->spheres.end()) it = w.s->spheres.insert(std::make_pair(n, fibonaccisphere(n))).first;
+        for (vec3 const& u : it->second)
+        {
+            vec3 p = c + u*r;
+            pp.addpoint(static_cast<int>(i) + 1, p.x, p.y, p.z);
+        }
+    }
+    calculate(*w.s, box, options, result);
+}
+
+void pomelocalculate2d(std::vector<double> const& xy, std::vector<int> const& labels, pomelobox const& box, pomelooptions const& options, pomeloresult& result, pomeloworkspace* workspace)
+{
+    if (xy.size() != 2*labels.size()) throw std::string("pomelo: xy needs two coordinates per label");
+    checkbox(box, true);
+    usestate w(workspace);
+    pointpattern& pp = w.s->pp;
+    pp.points.reserve(labels.size());
+    for (size_t i = 0; i != labels.size(); ++i)
+    {
+        pp.addpoint(labels[i], xy[2*i], xy[2*i + 1], 0);
+    }
+    voronoi2d vd;
+    vd.verbose = options.verbose;
+    vd.calculate(pp, box.xmin, box.xmax, box.ymin, box.ymax, box.xpbc, box.ypbc);
+
+    result.volume = vd.area;
+    setneighbors(vd.edgelength, result);
+    clearpoints(result);
+    clearmesh(result);
+    if (!options.mesh) return;
+    // the outlines are closed by repeating the first vertex, within the tolerance of the voronoi vertices
+    double const tolerance = 1e-9*std::max(box.xmax - box.xmin, box.ymax - box.ymin);
+    for (size_t l = 0; l != vd.polygons.size(); ++l)
+    {
+        for (std::vector<double> const& p : vd.polygons[l])
+        {
+            size_t n = p.size()/2;
+            if (n > 1 && std::fabs(p[0] - p[2*n - 2]) <= tolerance && std::fabs(p[1] - p[2*n - 1]) <= tolerance) --n;
+            for (size_t k = 0; k != n; ++k)
+            {
+                result.faceindex.push_back(result.vertex.size()/3);
+                result.vertex.push_back(p[2*k]);
+                result.vertex.push_back(p[2*k + 1]);
+                result.vertex.push_back(0);
+            }
+            result.faceoffset.push_back(result.faceindex.size());
+            result.facelabel.push_back(static_cast<unsigned int>(l));
+        }
+    }
+}
+
+
+// incremental diagram. Every surface point keeps its voronoi cell (volume, neighbor points and face areas) and its
+// place in the voro++ container, the values of a particle are summed from the cells of its points when asked for.
+// The stored neighbors are always up to date, so a move recalculates the neighbors of the removed points and the
+// cells that the new points cut
+struct pomeloincremental::state
+{
+    struct cell
+    {
+        int label;      // -1 for unused ids
+        int ijk;        // block and position of the point in the voro++ container
+        int q;
+        double volume;
+        std::vector<int> neighbor;
+        std::vector<double> area;
+    };
+
+    pomelobox box;
+    double epsilon;
+    std::unique_ptr<voro::container> con;
+    voro::particle_order order;
+    voro::voronoicell_neighbor c;
+    std::vector<cell> cells;                    // by point id
+    std::vector<int> freeids;
+    std::map<int, std::vector<int> > particles; // point ids by particle label
+    unsigned long long calculated;
+
+    void check(std::vector<double> const& xyz) const
+    {
+        if (xyz.size() % 3 != 0) throw std::string("pomelo: xyz needs three coordinates per point");
+        for (size_t i = 0; i != xyz.size(); i += 3)
+        {
+            if ((!box.xpbc && (xyz[i] < box.xmin || xyz[i] >= box.xmax))
+                || (!box.ypbc && (xyz[i + 1] < box.ymin || xyz[i + 1] >= box.ymax))
+                || (!box.zpbc && (xyz[i + 2] < box.zmin || xyz[i + 2] >= box.zmax)))
+                throw std::string("pomelo: surface point outside of the box");
+        }
+    };
+
+    int insert(int label, double x, double y, double z)
+    {
+        int id = static_cast<int>(cells.size());
+        if (!freeids.empty())
+        {
+            id = freeids.back();
+            freeids.pop_back();
+        }
+        else
+        {
+            if (cells.size() == static_cast<size_t>(std::numeric_limits<int>::max())) throw std::string("pomelo: too many surface points");
+            cells.push_back(cell());
+        }
+        order.op = order.o;
+        con->put(order, id, x, y, z);
+        cell& ce = cells[id];
+        ce.label = label;
+        ce.ijk = order.o[0];
+        ce.q = order.o[1];
+        ce.volume = 0;
+        ce.neighbor.clear();
+        ce.area.clear();
+        return id;
+    };
+
+    // points closer than epsilon to point id, searched in the block of the point and the blocks around it. epsilon is
+    // smaller than the blocks
+    void near(int id, std::vector<int>& ids) const
+    {
+        ids.clear();
+        cell const& ce = cells[id];
+        double const* p = con->p[ce.ijk] + 3*ce.q;
+        int bi = ce.ijk % con->nx;
+        int bj = (ce.ijk/con->nx) % con->ny;
+        int bk = ce.ijk/con->nxy;
+        double length[3] = {box.xmax - box.xmin, box.ymax - box.ymin, box.zmax - box.zmin};
+        bool pbc[3] = {box.xpbc, box.ypbc, box.zpbc};
+        std::set<int> blocks;
+        for (int i = bi - 1; i <= bi + 1; ++i)
+        for (int j = bj - 1; j <= bj + 1; ++j)
+        for (int k = bk - 1; k <= bk + 1; ++k)
+        {
+            int ni = i, nj = j, nk = k;
+            if (box.xpbc) ni = (ni + con->nx) % con->nx;
+            if (box.ypbc) nj = (nj + con->ny) % con->ny;
+            if (box.zpbc) nk = (nk + con->nz) % con->nz;
+            if (ni < 0 || ni >= con->nx || nj < 0 || nj >= con->ny || nk < 0 || nk >= con->nz) continue;
+            int b = ni + con->nx*nj + con->nxy*nk;
+            if (!blocks.insert(b).second) continue;
+            for (int q = 0; q != con->co[b]; ++q)
+            {
+                if (b == ce.ijk && q == ce.q) continue;
+                double d2 = 0;
+                for (int a = 0; a != 3; ++a)
+                {
+                    // nearest periodic image
+                    double d = con->p[b][3*q + a] - p[a];
+                    if (pbc[a]) d -= length[a]*std::round(d/length[a]);
+                    d2 += d*d;
+                }
+                if (d2 <= epsilon*epsilon) ids.push_back(con->id[b][q]);
+            }
+        }
+    };
+
+    // inserts one surface point, a point closer than epsilon to a point of the same particle is merged into it and -1
+    // is returned. The old points of the particles in replaced are left out, they are removed once all new points
+    // (added) are in
+    int place(int label, double x, double y, double z, std::set<int> const& replaced, std::set<int> const& added)
+    {
+        int id = insert(label, x, y, z);
+        std::vector<int> ids;
+        near(id, ids);
+        bool merged = false;
+        for (int n : ids)
+        {
+            if (replaced.count(cells[n].label) && !added.count(n)) continue;
+            if (cells[n].label == label)
+            {
+                merged = true;
+                continue;
+            }
+            erase(id);
+            throw std::string("pomelo: surface points of particles " + std::to_string(label) + " and " + std::to_string(cells[n].label) + " coincide");
+        }
+        if (!merged) return id;
+        erase(id);
+        return -1;
+    };
+
+    // the last point of the block takes the place of the removed one
+    void erase(int id)
+    {
+        cell& ce = cells[id];
+        int last = --con->co[ce.ijk];
+        if (ce.q != last)
+        {
+            int moved = con->id[ce.ijk][last];
+            con->id[ce.ijk][ce.q] = moved;
+            std::copy(con->p[ce.ijk] + 3*last, con->p[ce.ijk] + 3*last + 3, con->p[ce.ijk] + 3*ce.q);
+            cells[moved].q = ce.q;
+        }
+        ce.label = -1;
+        ce.neighbor.clear();
+        ce.area.clear();
+        freeids.push_back(id);
+    };
+
+    void compute(int id)
+    {
+        cell& ce = cells[id];
+        ++calculated;
+        ce.volume = 0;
+        ce.neighbor.clear();
+        ce.area.clear();
+        if (!con->compute_cell(c, ce.ijk, ce.q)) return;
+        ce.volume = c.volume();
+        c.neighbors(ce.neighbor);
+        c.face_areas(ce.area);
+    };
+
+    // face areas to the other particles, walls are left out
+    void faces(int label, std::map<unsigned int, double>& area) const
+    {
+        auto it = particles.find(label);
+        if (it == particles.end()) return;
+        for (int id : it->second)
+        {
+            cell const& ce = cells[id];
+            for (size_t k = 0; k != ce.neighbor.size(); ++k)
+            {
+                int n = ce.neighbor[k];
+                if (n < 0 || cells[n].label == label) continue;
+                area[cells[n].label] += ce.area[k];
+            }
+        }
+    };
+
+    double volume(int label) const
+    {
+        auto it = particles.find(label);
+        if (it == particles.end()) return 0;
+        double v = 0;
+        for (int id : it->second) v += cells[id].volume;
+        return v;
+    };
+};
+
+pomeloincremental::pomeloincremental(std::vector<double> const& xyz, std::vector<int> const& labels, pomelobox const& box, double epsilon) : s(new state)
+{
+    std::unique_ptr<state> guard(s);
+    checkbox(box, false);
+    if (xyz.size() != 3*labels.size()) throw std::string("pomelo: xyz needs three coordinates per label");
+    if (labels.empty()) throw std::string("pomelo: no surface points");
+    if (!(epsilon >= 0)) throw std::string("pomelo: epsilon cannot be negative");
+    s->box = box;
+    s->epsilon = epsilon;
+    s->calculated = 0;
+    s->check(xyz);
+
+    voro::pre_container pcon(box.xmin, box.xmax, box.ymin, box.ymax, box.zmin, box.zmax, box.xpbc, box.ypbc, box.zpbc);
+    for (size_t i = 0; i != labels.size(); ++i) pcon.put(static_cast<int>(i), xyz[3*i], xyz[3*i + 1], xyz[3*i + 2]);
+    int nx, ny, nz;
+    pcon.guess_optimal(nx, ny, nz);
+    s->con.reset(new voro::container(box.xmin, box.xmax, box.ymin, box.ymax, box.zmin, box.zmax, nx, ny, nz, box.xpbc, box.ypbc, box.zpbc, 8));
+    if (epsilon >= std::min(s->con->boxx, std::min(s->con->boxy, s->con->boxz))) throw std::string("pomelo: epsilon is larger than the blocks of the voro++ container");
+
+    s->cells.reserve(labels.size());
+    std::set<int> none;
+    for (size_t i = 0; i != labels.size(); ++i)
+    {
+        if (labels[i] < 0) throw std::string("pomelo: label out of range");
+        int id = s->place(labels[i], xyz[3*i], xyz[3*i + 1], xyz[3*i + 2], none, none);
+        if (id >= 0) s->particles[labels[i]].push_back(id);
+    }
+    for (size_t id = 0; id != s->cells.size(); ++id) s->compute(static_cast<int>(id));
+    guard.release();
+}
+
+pomeloincremental::~pomeloincremental()
+{
+    delete s;
+}
+
+void pomeloincremental::move(int label, std::vector<double> const& xyz)
+{
+    move(std::vector<int>(1, label), std::vector<std::vector<double> >(1, xyz));
+}
+
+void pomeloincremental::move(std::vector<int> const& labels, std::vector<std::vector<double> > const& xyz)
+{
+    if (labels.size() != xyz.size()) throw std::string("pomelo: one set of surface points per label needed");
+    for (size_t i = 0; i != labels.size(); ++i)
+    {
+        if (labels[i] < 0) throw std::string("pomelo: label out of range");
+        s->check(xyz[i]);
+    }
+    std::set<int> replaced(labels.begin(), labels.end());
+    if (replaced.size() != labels.size()) throw std::string("pomelo: particle moved twice");
+    s->calculated = 0;
+
+    // the new points go in before the old ones are removed, so a point that coincides with another particle leaves
+    // the diagram as it was
+    std::set<int> added;
+    std::vector<std::vector<int> > ids(labels.size());
+    try
+    {
+        for (size_t i = 0; i != labels.size(); ++i)
+        {
+            for (size_t k = 0; k < xyz[i].size(); k += 3)
+            {
+                int id = s->place(labels[i], xyz[i][k], xyz[i][k + 1], xyz[i][k + 2], replaced, added);
+                if (id < 0) continue;
+                ids[i].push_back(id);
+                added.insert(id);
+            }
+        }
+    }
+    catch (std::string const&)
+    {
+        for (int id : added) s->erase(id);
+        throw;
+    }
+
+    // the neighbors of the removed points change, and so do the cells that the new points cut
+    std::set<int> affected;
+    for (int label : labels)
+    {
+        auto it = s->particles.find(label);
+        if (it == s->particles.end()) continue;
+        for (int id : it->second)
+        {
+            for (int n : s->cells[id].neighbor) if (n >= 0) affected.insert(n);
+        }
+        for (int id : it->second) s->erase(id);
+        s->particles.erase(it);
+    }
+
+    for (size_t i = 0; i != labels.size(); ++i)
+    {
+        if (!ids[i].empty()) s->particles[labels[i]] = ids[i];
+    }
+    for (int id : added)
+    {
+        s->compute(id);
+        for (int n : s->cells[id].neighbor) if (n >= 0) affected.insert(n);
+    }
+    for (int id : added) affected.erase(id);
+
+    for (int id : affected)
+    {
+        if (s->cells[id].label >= 0) s->compute(id);
+    }
+}
+
+void pomeloincremental::translate(int label, double dx, double dy, double dz)
+{
+    auto it = s->particles.find(label);
+    if (it == s->particles.end()) throw std::string("pomelo: no particle with this label");
+    std::vector<double> xyz;
+    xyz.reserve(3*it->second.size());
+    for (int id : it->second)
+    {
+        state::cell const& ce = s->cells[id];
+        double const* p = s->con->p[ce.ijk] + 3*ce.q;
+        xyz.push_back(p[0] + dx);
+        xyz.push_back(p[1] + dy);
+        xyz.push_back(p[2] + dz);
+    }
+    move(label, xyz);
+}
+
+double pomeloincremental::volume(int label) const
+{
+    return s->volume(label);
+}
+
+void pomeloincremental::neighbors(int label, std::vector<unsigned int>& neighbor, std::vector<double>& facearea) const
+{
+    std::map<unsigned int, double> area;
+    s->faces(label, area);
+    neighbor.clear();
+    facearea.clear();
+    for (auto const& a : area)
+    {
+        neighbor.push_back(a.first);
+        facearea.push_back(a.second);
+    }
+}
+
+void pomeloincremental::result(pomeloresult& result) const
+{
+    size_t labels = s->particles.empty() ? 0 : s->particles.rbegin()->first + 1;
+    result.volume.assign(labels, 0);
+    std::vector<std::map<unsigned int, double> > facearea(labels);
+    for (auto const& p : s->particles)
+    {
+        result.volume[p.first] = s->volume(p.first);
+        s->faces(p.first, facearea[p.first]);
+    }
+    setneighbors(facearea, result);
+    clearpoints(result);
+    clearmesh(result);
+}
+
+unsigned long long pomeloincremental::calculatedcells() const
+{
+    return s->calculated;
+}
+
+unsigned long long pomeloincremental::cells() const
+{
+    return s->cells.size() - s->freeids.size();
+}
+
+
+struct pomelolocator::state
+{
+    locator lo;
+};
+
+pomelolocator::pomelolocator(std::vector<double> const& xyz, std::vector<int> const& labels, pomelobox const& box) : s(new state)
+{
+    std::unique_ptr<state> guard(s);
+    if (xyz.size() != 3*labels.size()) throw std::string("pomelo: xyz needs three coordinates per label");
+    checkbox(box, false);
+    pointpattern pp;
+    pp.points.reserve(labels.size());
+    for (size_t i = 0; i != labels.size(); ++i)
+    {
+        if (labels[i] < 0) throw std::string("pomelo: label out of range");
+        pp.addpoint(labels[i], xyz[3*i], xyz[3*i + 1], xyz[3*i + 2]);
+    }
+    s->lo.verbose = false;
+    s->lo.setup(pp, box.xmin, box.xmax, box.ymin, box.ymax, box.zmin, box.zmax, box.xpbc, box.ypbc, box.zpbc);
+    guard.release();
+}
+
+pomelolocator::~pomelolocator()
+{
+    delete s;
+}
+
+int pomelolocator::locate(double x, double y, double z) const
+{
+    return s->lo.locate(x, y, z);
+}
+
+void pomelolocator::locate(std::vector<double> const& probes, std::vector<int>& labels, unsigned int threads) const
+{
+    if (probes.size() % 3 != 0) throw std::string("pomelo: probes need three coordinates each");
+    s->lo.locate(probes, labels, threads);
+}
+
+
+// plain C interface
+struct pomelo_result
+{
+    pomeloresult r;
+    std::string error;
+};
+
+struct pomelo_incremental
+{
+    std::unique_ptr<pomeloincremental> d;
+    std::string error;
+};
+
+struct pomelo_locator
+{
+    std::unique_ptr<pomelolocator> l;
+    std::string error;
+};
+
+namespace
+{
+    pomelobox tobox(pomelo_box const* b)
+    {
+        if (b == nullptr) throw std::string("pomelo: no box");
+        return pomelobox{b->xmin, b->xmax, b->ymin, b->ymax, b->zmin, b->zmax, b->xpbc != 0, b->ypbc != 0, b->zpbc != 0};
+    }
+
+    // run f, errors are stored in error
+    template <typename F> int guarded(std::string& error, F f)
+    {
+        error.clear();
+        try
+        {
+            f();
+        }
+        catch (std::string const& e)
+        {
+            error = e;
+        }
+        catch (std::exception const& e)
+        {
+            error = std::string("pomelo: ") + e.what();
+        }
+        return error.empty() ? 0 : -1;
+    }
+
+    // run one calculation, errors are stored in the result
+    template <typename F> pomelo_result* guarded(F f)
+    {
+        pomelo_result* r = new pomelo_result;
+        guarded(r->error, [&]() { f(r->r); });
+        return r;
+    }
+}
+
+extern "C"
+{
+
+pomelo_result* pomelo_calculate(size_t n, const double* xyz, const int* labels, const pomelo_box* box, double epsilon, int mesh)
+{
+    return guarded([&](pomeloresult& r)
+    {
+        pomelooptions o;
+        o.epsilon = epsilon;
+        o.mesh = (mesh != 0);
+        pomelocalculate(std::vector<double>(xyz, xyz + 3*n), std::vector<int>(labels, labels + n), tobox(box), o, r);
+    });
+}
+
+pomelo_result* pomelo_calculate_triclinic(size_t n, const double* xyz, const int* labels, const pomelo_box* box, double xy, double xz, double yz, double epsilon, int mesh)
+{
+    return guarded([&](pomeloresult& r)
+    {
+        pomelooptions o;
+        o.epsilon = epsilon;
+        o.mesh = (mesh != 0);
+        o.triclinic = true;
+        o.xy = xy;
+        o.xz = xz;
+        o.yz = yz;
+        pomelocalculate(std::vector<double>(xyz, xyz + 3*n), std::vector<int>(labels, labels + n), tobox(box), o, r);
+    });
+}
+
+pomelo_result* pomelo_spheres(size_t n, const double* xyz, const double* radii, double spacing, double shrink, const pomelo_box* box, int mesh)
+{
+    return guarded([&](pomeloresult& r)
+    {
+        pomelooptions o;
+        o.mesh = (mesh != 0);
+        pomelospheres(std::vector<double>(xyz, xyz + 3*n), std::vector<double>(radii, radii + n), spacing, shrink, tobox(box), o, r);
+    });
+}
+
+pomelo_result* pomelo_calculate2d(size_t n, const double* xy, const int* labels, const pomelo_box* box, int mesh)
+{
+    return guarded([&](pomeloresult& r)
+    {
+        pomelooptions o;
+        o.mesh = (mesh != 0);
+        pomelocalculate2d(std::vector<double>(xy, xy + 2*n), std::vector<int>(labels, labels + n), tobox(box), o, r);
+    });
+}
+
+const char* pomelo_error(const pomelo_result* r)
+{
+    return r->error.empty() ? nullptr : r->error.c_str();
+}
+
+size_t pomelo_labels(const pomelo_result* r)
+{
+    return r->r.volume.size();
+}
+
+const double* pomelo_volume(const pomelo_result* r)
+{
+    return r->r.volume.data();
+}
+
+const unsigned long* pomelo_neighbor_offset(const pomelo_result* r)
+{
+    return r->r.neighboroffset.data();
+}
+
+const unsigned int* pomelo_neighbor(const pomelo_result* r)
+{
+    return r->r.neighbor.data();
+}
+
+const double* pomelo_face_area(const pomelo_result* r)
+{
+    return r->r.facearea.data();
+}
+
+
+size_t pomelo_vertices(const pomelo_result* r)
+{
+    return r->r.vertex.size()/3;
+}
+
+const double* pomelo_vertex(const pomelo_result* r)
+{
+    return r->r.vertex.data();
+}
+
+size_t pomelo_faces(const pomelo_result* r)
+{
+    return r->r.facelabel.size();
+}
+
+const unsigned long* pomelo_face_offset(const pomelo_result* r)
+{
+    return r->r.faceoffset.data();
+}
+
+const unsigned long* pomelo_face_index(const pomelo_result* r)
+{
+    return r->r.faceindex.data();
+}
+
+const unsigned int* pomelo_face_label(const pomelo_result* r)
+{
+    return r->r.facelabel.data();
+}
+
+
+void pomelo_free(pomelo_result* r)
+{
+    delete r;
+}
+
+
+pomelo_incremental* pomelo_incremental_create(size_t n, const double* xyz, const int* labels, const pomelo_box* box)
+{
+    pomelo_incremental* d = new pomelo_incremental;
+    guarded(d->error, [&]()
+    {
+        d->d.reset(new pomeloincremental(std::vector<double>(xyz, xyz + 3*n), std::vector<int>(labels, labels + n), tobox(box)));
+    });
+    return d;
+}
+
+int pomelo_incremental_move(pomelo_incremental* d, int label, size_t n, const double* xyz)
+{
+    return guarded(d->error, [&]()
+    {
+        if (!d->d) throw std::string("pomelo: diagram has not been created");
+        d->d->move(label, std::vector<double>(xyz, xyz + 3*n));
+    });
+}
+
+int pomelo_incremental_translate(pomelo_incremental* d, int label, double dx, double dy, double dz)
+{
+    return guarded(d->error, [&]()
+    {
+        if (!d->d) throw std::string("pomelo: diagram has not been created");
+        d->d->translate(label, dx, dy, dz);
+    });
+}
+
+double pomelo_incremental_volume(const pomelo_incremental* d, int label)
+{
+    return d->d ? d->d->volume(label) : 0;
+}
+
+pomelo_result* pomelo_incremental_result(const pomelo_incremental* d)
+{
+    return guarded([&](pomeloresult& r)
+    {
+        if (!d->d) throw std::string("pomelo: diagram has not been created");
+        d->d->result(r);
+    });
+}
+
+const char* pomelo_incremental_error(const pomelo_incremental* d)
+{
+    return d->error.empty() ? nullptr : d->error.c_str();
+}
+
+void pomelo_incremental_free(pomelo_incremental* d)
+{
+    delete d;
+}
+
+
+pomelo_locator* pomelo_locator_create(size_t n, const double* xyz, const int* labels, const pomelo_box* box)
+{
+    pomelo_locator* l = new pomelo_locator;
+    guarded(l->error, [&]()
+    {
+        l->l.reset(new pomelolocator(std::vector<double>(xyz, xyz + 3*n), std::vector<int>(labels, labels + n), tobox(box)));
+    });
+    return l;
+}
+
+int pomelo_locate(const pomelo_locator* l, size_t m, const double* probes, int* result, unsigned int threads)
+{
+    if (!l->l) return -1;
+    try
+    {
+        std::vector<int> labels;
+        l->l->locate(std::vector<double>(probes, probes + 3*m), labels, threads);
+        std::copy(labels.begin(), labels.end(), result);
+    }
+    catch (...)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+const char* pomelo_locator_error(const pomelo_locator* l)
+{
+    return l->error.empty() ? nullptr : l->error.c_str();
+}
+
+void pomelo_locator_free(pomelo_locator* l)
+{
+    delete l;
+}
+
+}
@@ -0,0 +1,166 @@
+/* 
+Copyright 2016 Simon Weis and Philipp Schoenhoefer
+
+This file is part of Pomelo.
+
+Pomelo is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Pomelo is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Pomelo.  If not, see <http://www.gnu.org/licenses/>.
+
+The development of Pomelo took place at the Friedrich-Alexander University of Erlangen and was funded by the German Research Foundation (DFG) Forschergruppe FOR1548 "Geometry and Physics of Spatial Random Systems" (GPSRS). 
+*/
+#ifndef LIBPOMELO_H_GUARD_123456
+#define LIBPOMELO_H_GUARD_123456
+
+#include <vector>
+#include <string>
+
+// in-memory interface of pomelo (libpomelo.a), for programs that want set voronoi diagrams without writing
+// position files and parsing cell.poly. All functions are reentrant, they do not touch the filesystem and do not
+// print anything unless asked to (pomelooptions::verbose). Errors are thrown as std::string. See pomelo.h for the plain
+// C interface. The pomelo binary calculates its set voronoi diagrams of surface points with pomelocalculate
+
+// simulation box, the z range is ignored by pomelocalculate2d
+struct pomelobox
+{
+    double xmin, xmax, ymin, ymax, zmin, zmax;
+    bool xpbc, ypbc, zpbc;
+};
+
+struct pomelooptions
+{
+    double epsilon;     // surface points closer than this are merged
+    bool mesh;          // return the faces of the merged cells
+    bool triclinic;     // 3d only: the box is a periodic parallelepiped with the edges (lx, 0, 0), (xy, ly, 0) and
+    double xy, xz, yz;  // (xz, yz, lz) as in LAMMPS, the box has to be periodic in all directions
+    bool verbose;       // progress output on std::cout
+    bool cells;         // 3d only: return the surface points after merging and their unmerged voronoi cells
+    std::vector<int> selected;  // 3d only: labels of the particles whose cells are calculated, all if empty. The surface
+                                // points of the other particles only bound them, they get volume 0 and no neighbors
+
+    pomelooptions () : epsilon(1e-12), mesh(false), triclinic(false), xy(0), xz(0), yz(0), verbose(false), cells(false)
+    {};
+};
+
+// all arrays are indexed by particle label, labels without points have volume 0 and no neighbors
+// neighbors and meshes are stored in compressed sparse row layout
+struct pomeloresult
+{
+    std::vector<double> volume;                 // set voronoi cell volume (area in 2d)
+    std::vector<unsigned long> neighboroffset;  // neighbors of label l are neighbor[neighboroffset[l]] ... neighbor[neighboroffset[l+1] - 1]
+    std::vector<unsigned int> neighbor;         // neighbor labels, sorted
+    std::vector<double> facearea;               // area (edge length in 2d) of the face to every neighbor, same layout
+
+    // only with pomelooptions::mesh: the merged cells as polygons on shared vertices, the same as in cell.poly.
+    // face f has the vertices faceindex[faceoffset[f]] ... faceindex[faceoffset[f+1] - 1] and belongs to facelabel[f].
+    // Periodic cells are unwrapped around the first surface point of their particle
+    std::vector<double> vertex;                 // x y z of every vertex
+    std::vector<unsigned long> faceoffset;
+    std::vector<unsigned long> faceindex;
+    std::vector<unsigned int> facelabel;
+
+    // only with pomelooptions::cells: every surface point that is left after merging, with the number of faces and the
+    // volume of its own voronoi cell (0 faces if the cell was not calculated)
+    std::vector<double> point;                  // x y z of every point
+    std::vector<int> pointlabel;
+    std::vector<unsigned int> pointfaces;
+    std::vector<double> pointvolume;
+};
+
+// warm state for repeated calls from one thread: the sampled unit spheres, the point buffers and the voro++ container
+// (reused while box and division stay the same) are kept between calls. A workspace must not be shared between threads
+class pomeloworkspace
+{
+public:
+    pomeloworkspace();
+    ~pomeloworkspace();
+
+    struct state;
+    state* s;
+
+private:
+    pomeloworkspace(pomeloworkspace const&);
+    pomeloworkspace& operator=(pomeloworkspace const&);
+};
+
+// set voronoi diagram that stays in memory and follows particle moves, e.g. in Monte Carlo simulations. Moving a
+// particle replaces its surface points and recalculates only the voronoi cells of the surface points whose neighborhood
+// changed, so the cost of a move does not depend on the system size. Surface points of one particle closer than
+// epsilon are merged as in pomelocalculate, surface points of different particles closer than epsilon are an error
+class pomeloincremental
+{
+public:
+    pomeloincremental(std::vector<double> const& xyz, std::vector<int> const& labels, pomelobox const& box, double epsilon = 1e-12);
+    ~pomeloincremental();
+
+    // replace the surface points of particle label, a new label adds a particle and an empty xyz removes it.
+    // Nothing is changed if a point lies outside of a non periodic box or coincides with a point of another particle
+    void move(int label, std::vector<double> const& xyz);
+    // move several particles at once, xyz[i] are the new surface points of particle labels[i]. Cells next to more than
+    // one of them are calculated only once
+    void move(std::vector<int> const& labels, std::vector<std::vector<double> > const& xyz);
+    // move with the current surface points of the particle shifted by dx, dy, dz
+    void translate(int label, double dx, double dy, double dz);
+
+    double volume(int label) const;
+    // sorted neighbor labels of one particle and the areas of the faces to them
+    void neighbors(int label, std::vector<unsigned int>& neighbor, std::vector<double>& facearea) const;
+    // volumes, neighbors and face areas of all particles, without mesh
+    void result(pomeloresult& result) const;
+    // number of voronoi cells calculated by the last move (by the constructor before the first move)
+    unsigned long long calculatedcells() const;
+    // number of voronoi cells in the diagram, one per surface point that was not merged
+    unsigned long long cells() const;
+
+    struct state;
+
+private:
+    state* s;
+
+    pomeloincremental(pomeloincremental const&);
+    pomeloincremental& operator=(pomeloincremental const&);
+};
+
+// which set voronoi cell contains a point: the label of the particle with the nearest surface point. No voronoi cell is
+// calculated, the surface points are only sorted into a grid. A locator can be shared between threads
+class pomelolocator
+{
+public:
+    pomelolocator(std::vector<double> const& xyz, std::vector<int> const& labels, pomelobox const& box);
+    ~pomelolocator();
+
+    // label of the cell that contains (x, y, z), -1 outside of a non periodic box
+    int locate(double x, double y, double z) const;
+    // labels of all probe points, probes holds x y z of every point. 0 threads uses all cores
+    void locate(std::vector<double> const& probes, std::vector<int>& labels, unsigned int threads = 0) const;
+
+    struct state;
+
+private:
+    state* s;
+
+    pomelolocator(pomelolocator const&);
+    pomelolocator& operator=(pomelolocator const&);
+};
+
+// set voronoi diagram of surface points, xyz holds x y z of every point and labels the particle label of every point
+void pomelocalculate(std::vector<double> const& xyz, std::vector<int> const& labels, pomelobox const& box, pomelooptions const& options, pomeloresult& result, pomeloworkspace* workspace = nullptr);
+
+// spheres with centers xyz and radii, sphere i gets label i. The surfaces are sampled on a fibonacci lattice with the
+// given point spacing, shrunk by shrink, as in the SPHEREPOLY mode
+void pomelospheres(std::vector<double> const& xyz, std::vector<double> const& radii, double spacing, double shrink, pomelobox const& box, pomelooptions const& options, pomeloresult& result, pomeloworkspace* workspace = nullptr);
+
+// set voronoi diagram in the x y plane, xy holds x y of every point. The mesh holds the outlines of the cells as faces
+// with z = 0, each vertex appears once per outline
+void pomelocalculate2d(std::vector<double> const& xy, std::vector<int> const& labels, pomelobox const& box, pomelooptions const& options, pomeloresult& result, pomeloworkspace* workspace = nullptr);
+
+#endif
@@ -0,0 +1,218 @@
+/* 
+Copyright 2016 Simon Weis and Philipp Schoenhoefer
+
+This file is part of Pomelo.
+
+Pomelo is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Pomelo is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Pomelo.  If not, see <http://www.gnu.org/licenses/>.
+
+The development of Pomelo took place at the Friedrich-Alexander University of Erlangen and was funded by the German Research Foundation (DFG) Forschergruppe FOR1548 "Geometry and Physics of Spatial Random Systems" (GPSRS). 
+*/
+#ifndef LOCATOR_H_GUARD_123456
+#define LOCATOR_H_GUARD_123456
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <algorithm>
+#include <limits>
+#include <thread>
+#include <cmath>
+#include "pointpattern.hpp"
+
+// point location in the set voronoi diagram: the set voronoi cell of a particle is the union of the voronoi cells of
+// its surface points, so a point lies in the cell of the particle that owns the nearest surface point. The surface
+// points are sorted into a grid of bins that is searched shell by shell, no voronoi cell is calculated. After the
+// setup the object is only read, locate can be called from several threads at the same time
+class locator
+{
+public:
+    bool verbose;               // progress output on std::cout
+    unsigned int nx, ny, nz;    // number of bins
+
+    locator () : verbose(true), nx(0), ny(0), nz(0)
+    {};
+
+    void setup(pointpattern const& pp, double xmin, double xmax, double ymin, double ymax, double zmin, double zmax, bool xpbc, bool ypbc, bool zpbc)
+    {
+        origin = {xmin, ymin, zmin};
+        length = {xmax - xmin, ymax - ymin, zmax - zmin};
+        pbc = {xpbc, ypbc, zpbc};
+        if (length[0] <= 0 || length[1] <= 0 || length[2] <= 0) throw std::string("box for point location has no volume");
+        size_t const n = pp.points.size();
+        if (n == 0) throw std::string("no surface points for point location");
+
+        // about two points per bin
+        double binsize = std::cbrt(2.0*length[0]*length[1]*length[2]/static_cast<double>(n));
+        nx = std::max(1u, static_cast<unsigned int>(length[0]/binsize));
+        ny = std::max(1u, static_cast<unsigned int>(length[1]/binsize));
+        nz = std::max(1u, static_cast<unsigned int>(length[2]/binsize));
+        b = {length[0]/nx, length[1]/ny, length[2]/nz};
+        bmin = std::min(b[0], std::min(b[1], b[2]));
+        if (verbose) std::cout << "point location on " << n << " surface points in (" << nx << " " << ny << " " << nz << ") bins" << std::endl;
+
+        // points in periodic directions are wrapped into the box. The points are stored bin by bin, the points of
+        // bin k are start[k] ... start[k+1] - 1
+        std::vector<size_t> bin(n);
+        start.assign(static_cast<size_t>(nx)*ny*nz + 1, 0);
+        for (size_t i = 0; i != n; ++i)
+        {
+            point const& p = pp.points[i];
+            if (p.l < 0) throw std::string("negative particle label for point location");
+            double r[3] = {p.x, p.y, p.z};
+            wrap(r);
+            bin[i] = binof(r);
+            ++start[bin[i] + 1];
+        }
+        for (size_t k = 1; k != start.size(); ++k) start[k] += start[k-1];
+        xyz.resize(3*n);
+        label.resize(n);
+        std::vector<size_t> fill(start.begin(), start.end() - 1);
+        for (size_t i = 0; i != n; ++i)
+        {
+            point const& p = pp.points[i];
+            double r[3] = {p.x, p.y, p.z};
+            wrap(r);
+            size_t j = fill[bin[i]]++;
+            xyz[3*j] = r[0];
+            xyz[3*j+1] = r[1];
+            xyz[3*j+2] = r[2];
+            label[j] = p.l;
+        }
+    };
+
+    // label of the particle whose set voronoi cell contains (x, y, z), -1 outside of a non periodic box
+    int locate(double x, double y, double z) const
+    {
+        double r[3] = {x, y, z};
+        for (unsigned int d = 0; d != 3; ++d)
+        {
+            if (!pbc[d] && (r[d] < origin[d] || r[d] > origin[d] + length[d])) return -1;
+        }
+        wrap(r);
+        long const ix = binindex(r[0], 0);
+        long const iy = binindex(r[1], 1);
+        long const iz = binindex(r[2], 2);
+        long const maxring = std::max(nx, std::max(ny, nz));
+
+        double best = std::numeric_limits<double>::max();
+        int found = -1;
+        for (long ring = 0; ring <= maxring; ++ring)
+        {
+            for (long jz = iz - ring; jz <= iz + ring; ++jz)
+            {
+                long const sz = shell(jz, nz);
+                if (!pbc[2] && sz != 0) continue;
+                bool const zedge = (jz == iz - ring || jz == iz + ring);
+                for (long jy = iy - ring; jy <= iy + ring; ++jy)
+                {
+                    long const sy = shell(jy, ny);
+                    if (!pbc[1] && sy != 0) continue;
+                    bool const yedge = zedge || jy == iy - ring || jy == iy + ring;
+                    for (long jx = ix - ring; jx <= ix + ring; ++jx)
+                    {
+                        // only the surface of the shell, the inside has been searched before
+                        if (!yedge && jx != ix - ring && jx != ix + ring) continue;
+                        long const sx = shell(jx, nx);
+                        if (!pbc[0] && sx != 0) continue;
+
+                        // the bin and the periodic image it is seen in
+                        double const dx = r[0] - sx*length[0];
+                        double const dy = r[1] - sy*length[1];
+                        double const dz = r[2] - sz*length[2];
+                        size_t const k = (static_cast<size_t>(jz - sz*nz)*ny + (jy - sy*ny))*nx + (jx - sx*nx);
+                        for (size_t j = start[k]; j != start[k+1]; ++j)
+                        {
+                            double const ex = xyz[3*j] - dx;
+                            double const ey = xyz[3*j+1] - dy;
+                            double const ez = xyz[3*j+2] - dz;
+                            double const d2 = ex*ex + ey*ey + ez*ez;
+                            if (d2 < best)
+                            {
+                                best = d2;
+                                found = label[j];
+                            }
+                        }
+                    }
+                }
+            }
+            // all points outside of the searched shells are at least ring*bmin away
+            double const reach = ring*bmin;
+            if (found >= 0 && best <= reach*reach) break;
+        }
+        return found;
+    };
+
+    // probes holds x y z of every probe point, labels gets the label of every probe. The probes are split into
+    // contiguous blocks for the threads, 0 threads uses all cores
+    void locate(std::vector<double> const& probes, std::vector<int>& labels, unsigned int threads = 0) const
+    {
+        size_t const n = probes.size()/3;
+        labels.resize(n);
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        size_t const block = (n + threads - 1)/threads;
+        std::vector<std::thread> workers;
+        for (unsigned int t = 0; t != threads && t*block < n; ++t)
+        {
+            workers.push_back(std::thread([&, t]()
+            {
+                size_t const last = std::min(n, (t + 1)*block);
+                for (size_t i = t*block; i != last; ++i)
+                {
+                    labels[i] = locate(probes[3*i], probes[3*i+1], probes[3*i+2]);
+                }
+            }));
+        }
+        for (auto& w : workers) w.join();
+    };
+
+private:
+    std::vector<double> origin, length, b;
+    std::vector<bool> pbc;
+    double bmin;
+    std::vector<size_t> start;
+    std::vector<double> xyz;    // points relative to the box origin, sorted by bin
+    std::vector<int> label;
+
+    // relative to the box origin and wrapped into the box along periodic axes
+    void wrap(double* r) const
+    {
+        for (unsigned int d = 0; d != 3; ++d)
+        {
+            r[d] -= origin[d];
+            if (pbc[d]) r[d] -= length[d]*std::floor(r[d]/length[d]);
+        }
+    };
+
+    long binindex(double v, unsigned int d) const
+    {
+        unsigned int const n = (d == 0) ? nx : ((d == 1) ? ny : nz);
+        long i = static_cast<long>(std::floor(v/b[d]));
+        if (i < 0) return 0;
+        if (i >= static_cast<long>(n)) return n - 1;
+        return i;
+    };
+
+    size_t binof(double const* r) const
+    {
+        return (static_cast<size_t>(binindex(r[2], 2))*ny + binindex(r[1], 1))*nx + binindex(r[0], 0);
+    };
+
+    // periodic image of bin j along an axis with n bins
+    static long shell(long j, unsigned int n)
+    {
+        return static_cast<long>(std::floor(static_cast<double>(j)/n));
+    };
+};
+
+#endif
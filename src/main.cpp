@@ -22,7 +22,10 @@ The development of Pomelo took place at the Friedrich-Alexander University of Er
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <map>
+#include <set>
+#include <algorithm>
 #include <limits>
 #include <sys/stat.h>
 #include "include.hpp"
@@ -34,11 +37,26 @@ The development of Pomelo took place at the Friedrich-Alexander University of Er
 #include "parsetetra_blunt.hpp"
 #include "parsesphcyl.hpp"
 #include "parseellipsoids.hpp"
+#include "parsepolyhedra.hpp"
+#include "parsesuperquadrics.hpp"
+#include "parseclumps.hpp"
+#include "parsemesh.hpp"
+#include "parseimage.hpp"
+#include "parseplanar.hpp"
 #include "pointpattern.hpp"
 #include "duplicationremover.hpp"
 #include "writerpoly.hpp"
 #include "writeroff.hpp"
 #include "postprocessing.hpp"
+#include "shapetemplate.hpp"
+#include "convergence.hpp"
+#include "laguerre.hpp"
+#include "quadraturespheres.hpp"
+#include "voxelgrid.hpp"
+#include "trajectory.hpp"
+#include "selection.hpp"
+#include "locator.hpp"
+#include "libpomelo.hpp"
 #include "output.hpp"
 
 std::string version = "0.1.3";
@@ -48,32 +66,441 @@ using namespace sel;
 using namespace voro;
 
 
-void  getFaceVerticesOfFace( std::vector<int>& f, unsigned int k, std::vector<unsigned int>& vertexList)
+// save set voronoi volumes, only of the selected particles if a selection is given
+void saveVolumes(std::vector<double> const& volumeMap, std::string const& folder, std::vector<bool> const& selection = std::vector<bool>())
 {
-    vertexList.clear();
+    std::cout << "save set voronoi cell volumes" << std::endl;
+    std::ofstream out(folder+"setVoronoiVolumes.dat");
+    out << "#1_particle label #2_set voronoi cell volume\n";
+    for (unsigned long long i = 0; i != volumeMap.size(); ++i)
+    {
+        if (!selection.empty() && (i >= selection.size() || !selection[i])) continue;
+        out << i << " " << std::setprecision(12) << volumeMap[i] << "\n";
+    }
+    out.close();
+}
+
+
+// save the area of the faces between neighboring set voronoi cells
+void saveFaces(std::vector<std::map<unsigned int, double> > const& facearea, std::string const& folder, std::vector<bool> const& selection = std::vector<bool>())
+{
+    std::cout << "save set voronoi face areas" << std::endl;
+    std::ofstream out(folder+"setVoronoiFaces.dat");
+    out << "#1_particle label #2_neighbor label #3_face area\n";
+    for (unsigned long long i = 0; i != facearea.size(); ++i)
+    {
+        if (!selection.empty() && (i >= selection.size() || !selection[i])) continue;
+        for (auto const& f : facearea[i])
+        {
+            out << i << " " << f.first << " " << std::setprecision(12) << f.second << "\n";
+        }
+    }
+    out.close();
+}
+
+
+// label of the set voronoi cell that contains every probe point (x y z per line) of the probe file
+int saveLocations(pointpattern const& pp, std::string const& probefile, unsigned int threads, std::string const& folder, double xmin, double xmax, double ymin, double ymax, double zmin, double zmax, bool xpbc, bool ypbc, bool zpbc)
+{
+    std::ifstream in(probefile);
+    if (!in.good())
+    {
+        std::cerr << "cannot open probe file " << probefile << std::endl;
+        return -1;
+    }
+    std::vector<double> probes;
+    std::string line;
+    while (std::getline(in, line))
+    {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream ss(line);
+        double x, y, z;
+        if (!(ss >> x >> y >> z))
+        {
+            std::cerr << "cannot parse probe point: " << line << std::endl;
+            return -1;
+        }
+        probes.push_back(x);
+        probes.push_back(y);
+        probes.push_back(z);
+    }
+    std::cout << "locating " << probes.size()/3 << " probe points" << std::endl;
+
+    locator lo;
+    lo.setup(pp, xmin, xmax, ymin, ymax, zmin, zmax, xpbc, ypbc, zpbc);
+    std::vector<int> labels;
+    lo.locate(probes, labels, threads);
+
+    std::cout << "save probe point locations" << std::endl;
+    std::ofstream out(folder+"locate.dat");
+    out << "#1_x #2_y #3_z #4_particle label (-1 outside of the box)\n";
+    out << std::setprecision(12);
+    for (size_t i = 0; i != labels.size(); ++i)
+    {
+        out << probes[3*i] << " " << probes[3*i+1] << " " << probes[3*i+2] << " " << labels[i] << "\n";
+    }
+    out.close();
+    std::cout << "\nworking for you has been nice. Thank you for using me & see you soon. :) "<< std::endl;
+    return 0;
+}
+
+
+// write the merged cells as poly and off file
+int writeCells(writerpoly const& pw, output const& outMode, std::string const& folder)
+{
+    std::cout << std::endl;
+    // Write poly file for karambola
+    if(outMode.savepoly == true)
+    {
+        std::cout << "writing poly file: " << folder + "cell.poly" << std::endl;
+        std::ofstream file;
+
+        file.open(folder + "cell.poly");
+        if (!file.good())
+        {
+            std::cerr << "error: cannot open poly file for write" << std::endl;
+            throw std::string("error: cannot open poly file for write");
+        }
+        file << pw;
+        file.close();
+    }
+    if(outMode.saveoff == true)
+    {
+        std::cout << "writing off file" << std::endl;
+        std::ofstream file;
+        file.open(folder+"cell.off");
+        if (!file.good())
+        {
+            std::cerr << "error: cannot open off file for write" << std::endl;
+            throw std::string("error: cannot open off file for write");
+        }
+        writeroff wo(pw);
+        file << wo;
+        file.close();
+    }
+
+    std::cout << "\nworking for you has been nice. Thank you for using me & see you soon. :) "<< std::endl;
+
+    return 0;
+}
+
+
+// save the merged cells (poly, off, reduced) and the cell volumes
+int saveCells(writerpoly& pw, std::vector<double> const& volumeMap, unsigned long long numberofvertices, output const& outMode, std::string const& folder, double epsilon, double xmin, double xmax, double ymin, double ymax, double zmin, double zmax, int nx, int ny, int nz, std::vector<bool> const& selection = std::vector<bool>())
+{
+    if(outMode.postprocessing == true)
+    {
+        saveVolumes(volumeMap, folder, selection);
+    } 
+
+    if (numberofvertices == 0)
+    {
+        std::cout << "\nall Voronoi Vertices have been removed. Check for periodic boundary conditions. skipping further calculation." << std::endl;
+        std::cout << "\nworking for you has been nice. Thank you for using me & see you soon. :) "<< std::endl;
+        return 0;
+    }
+    // save point pattern output
+    if(outMode.savereduced == true)
+    {
+        pw.savePointPatternForGnuplot(folder + "reduced.xyz");
+    }
+
+    std::cout << std::endl;
+    // remove duplicates and label back indices
+    pw.removeduplicates(epsilon, xmin, xmax, ymin, ymax, zmin, zmax, nx, ny, nz);
+    return writeCells(pw, outMode, folder);
+}
+
+
+// the surface points of a pointpattern as arrays for libpomelo, in the plane only x and y
+void toarrays(pointpattern& pp, bool planar, std::vector<double>& xyz, std::vector<int>& labels)
+{
+    xyz.reserve((planar ? 2 : 3)*pp.points.size());
+    labels.reserve(pp.points.size());
+    for (point const& p : pp.points)
+    {
+        xyz.push_back(p.x);
+        xyz.push_back(p.y);
+        if (!planar) xyz.push_back(p.z);
+        labels.push_back(p.l);
+    }
+    pp.clear();
+    std::vector<point>().swap(pp.points);
+}
+
+
+// face areas by particle label from the compressed rows of a libpomelo result
+std::vector<std::map<unsigned int, double> > facemaps(pomeloresult const& result)
+{
+    std::vector<std::map<unsigned int, double> > facearea(result.volume.size());
+    for (size_t l = 0; l != result.volume.size(); ++l)
+    {
+        for (unsigned long k = result.neighboroffset[l]; k != result.neighboroffset[l+1]; ++k)
+        {
+            facearea[l][result.neighbor[k]] = result.facearea[k];
+        }
+    }
+    return facearea;
+}
+
+
+// 2d cells of a pomelocalculate2d result as closed outlines, one block per outline
+void saveOutlines(pomeloresult const& result, std::string const& filename)
+{
+    std::ofstream out(filename);
+    if (!out.good()) throw std::string("error: cannot open " + filename + " for write");
+    out << "#1_x #2_y, one outline per block\n";
+    out << std::setprecision(12);
+    for (size_t f = 0; f != result.facelabel.size(); ++f)
+    {
+        out << "# particle " << result.facelabel[f] << "\n";
+        for (unsigned long k = result.faceoffset[f]; k != result.faceoffset[f+1]; ++k)
+        {
+            out << result.vertex[3*result.faceindex[k]] << " " << result.vertex[3*result.faceindex[k] + 1] << "\n";
+        }
+        if (result.faceoffset[f+1] != result.faceoffset[f])
+        {
+            unsigned long first = result.faceindex[result.faceoffset[f]];
+            out << result.vertex[3*first] << " " << result.vertex[3*first + 1] << "\n";
+        }
+        out << "\n\n";
+    }
+}
+
+
+// save the result of pomelocalculate: surface points, custom.dat, volumes, faces and the merged cells (poly, off, reduced)
+int saveResult(pomeloresult const& result, output const& outMode, std::string const& folder, std::vector<bool> const& selection)
+{
+    if (outMode.savesurface == true)
+    {
+        std::cout << "save surface triangulation file" << std::endl;
+        pointpattern surface;
+        for (size_t i = 0; i != result.pointlabel.size(); ++i)
+        {
+            surface.addpoint(result.pointlabel[i], result.point[3*i], result.point[3*i+1], result.point[3*i+2]);
+        }
+        std::ofstream file;
+        file.open(folder + "surface_triangulation.xyz");
+        file << surface;
+        file.close();
+    }
+    std::cout << std::endl;
+
+    if (outMode.postprocessing == true)
+    {
+        // id, number of faces and volume of every calculated (unmerged) voronoi cell
+        std::ofstream custom(folder + "custom.dat");
+        custom << std::setprecision(6);
+        for (size_t i = 0; i != result.pointfaces.size(); ++i)
+        {
+            if (result.pointfaces[i] == 0) continue;
+            custom << i << " " << result.pointfaces[i] << " " << result.pointvolume[i] << "\n";
+        }
+        custom.close();
+        std::cout << "Performing Postprocessing for normal (unmerged) Voronoi Cells" << std::endl;
+        DoPostProcessing(folder);
+    }
+    else
+    {
+        std::cout << "skipping postprocessing" << std::endl;
+    }
+    std::cout << std::endl;
 
-    // iterate through face-vertices vector bracketed
-    // (number of vertices for face 1) vertex 1 ID face 1, vertex 2 ID face 1 , ... (number of vertices for face 2, ...
-    unsigned long long index = 0;
-    // we are at face k, so we have to iterate through the face vertices vector up to k
-    for (unsigned long long cc = 0; cc <= k; cc++)
+    if (outMode.postprocessing == true)
     {
+        saveFaces(facemaps(result), folder, selection);
+        saveVolumes(result.volume, folder, selection);
+    }
+    if (result.facelabel.empty())
+    {
+        std::cout << "\nall Voronoi Vertices have been removed. Check for periodic boundary conditions. skipping further calculation." << std::endl;
+        std::cout << "\nworking for you has been nice. Thank you for using me & see you soon. :) "<< std::endl;
+        return 0;
+    }
 
-        unsigned long long b = f[index];    // how many vertices does the current face (index) have?
-        // iterate index "number of vertices of this face" forward
-        for (unsigned long long bb = 1; bb <= b; bb++)
+    // the faces with their merged vertices, one block per face
+    if (outMode.savereduced == true)
+    {
+        writerpoly faces;
+        faces.verbose = false;
+        for (size_t f = 0; f != result.facelabel.size(); ++f)
         {
-            index++;
-            // if we have found the correct face, get all the vertices for this face and save them
-            if (cc == k)
+            std::vector<double> positionlist;
+            for (unsigned long k = result.faceoffset[f+1]; k != result.faceoffset[f]; --k)
             {
-                //std::cout << "\t" << f[index] << std::endl;
-                int vertexindex = f[index];
-                vertexList.push_back(vertexindex);
+                unsigned long index = result.faceindex[k-1];
+                positionlist.insert(positionlist.end(), result.vertex.begin() + 3*index, result.vertex.begin() + 3*index + 3);
             }
+            faces.addface(positionlist, result.facelabel[f]);
         }
-        index++;
+        faces.savePointPatternForGnuplot(folder + "reduced.xyz");
     }
+
+    // the mesh in the layout writerpoly has after removeduplicates: vertices labelled from 1, faces numbered from 1 and
+    // stored in reverse order
+    writerpoly pw;
+    for (size_t i = 0; 3*i != result.vertex.size(); ++i)
+    {
+        pw.p.addpoint(static_cast<int>(i) + 1, result.vertex[3*i], result.vertex[3*i+1], result.vertex[3*i+2]);
+    }
+    for (size_t f = 0; f != result.facelabel.size(); ++f)
+    {
+        std::vector<unsigned int> face;
+        for (unsigned long k = result.faceoffset[f+1]; k != result.faceoffset[f]; --k) face.push_back(result.faceindex[k-1] + 1);
+        pw.faces[f+1] = face;
+        pw.faceCellMap[f+1] = result.facelabel[f];
+    }
+    return writeCells(pw, outMode, folder);
+}
+
+
+// the coarsest spacing of the convergence study is a quarter of the median particle size (extent of the surface triangulation)
+double coarsestspacing(pointpattern const& pp)
+{
+    std::map<int, std::pair<point, point> > extent;
+    for (point const& p : pp.points)
+    {
+        auto it = extent.find(p.l);
+        if (it == extent.end())
+        {
+            extent.insert(std::make_pair(p.l, std::make_pair(p, p)));
+            continue;
+        }
+        point& lo = it->second.first;
+        point& hi = it->second.second;
+        lo.x = std::min(lo.x, p.x); lo.y = std::min(lo.y, p.y); lo.z = std::min(lo.z, p.z);
+        hi.x = std::max(hi.x, p.x); hi.y = std::max(hi.y, p.y); hi.z = std::max(hi.z, p.z);
+    }
+    if (extent.empty()) throw std::string("no particles for the convergence study");
+    std::vector<double> sizes;
+    for (auto const& e : extent)
+    {
+        point const& lo = e.second.first;
+        point const& hi = e.second.second;
+        sizes.push_back(std::max(hi.x - lo.x, std::max(hi.y - lo.y, hi.z - lo.z)));
+    }
+    std::nth_element(sizes.begin(), sizes.begin() + sizes.size()/2, sizes.end());
+    double spacing = 0.25*sizes[sizes.size()/2];
+    if (spacing <= 0) throw std::string("particles are too small for the convergence study");
+    return spacing;
+}
+
+
+// the file is parsed once with its own resolution, then the parsed particles are resampled for every level,
+// which doubles the number of points. Used for SPHEREPOLY, ELLIP, SPHCYL, SUPERQ, CLUMP and MESH
+template <typename P> void convergeSpacing(P& p, std::string const& filename, convergencestudy& study)
+{
+    pointpattern pp;
+    p.parse(filename, pp);
+    study.setboundaries(p.xmin, p.xmax, p.ymin, p.ymax, p.zmin, p.zmax, p.xpbc, p.ypbc, p.zpbc);
+    double spacing = coarsestspacing(pp);
+    for (int level = 0; level != 6; ++level)
+    {
+        pp.clear();
+        p.forceddensity.spacing = spacing;
+        p.sample(pp);
+        study.addlevel("spacing=" + std::to_string(spacing), pp);
+        spacing /= std::sqrt(2.0);
+    }
+}
+
+
+// every level subdivides the faces once more, pp holds the parsed particles with one subdivision.
+// Used for TETRA, TETRABLUNT and POLYHEDRON, sample(iterations, pp) resamples the parsed particles
+template <typename P, typename F> void convergeIterations(P const& p, pointpattern& pp, F sample, convergencestudy& study)
+{
+    study.setboundaries(p.xmin, p.xmax, p.ymin, p.ymax, p.zmin, p.zmax, p.xpbc, p.ypbc, p.zpbc);
+    for (int it = 1; it <= 5; ++it)
+    {
+        if (it > 1)
+        {
+            pp.clear();
+            sample(it, pp);
+        }
+        study.addlevel("iterations=" + std::to_string(it), pp);
+    }
+}
+
+
+// run the convergence study and save the result to convergence.dat in the output folder
+int runConvergence(cmdlParser const& cp, std::string const& folder)
+{
+    convergencestudy study(cp.converge);
+    pointpattern pp;
+
+    if (cp.thisMode == SPHEREPOLY)
+    {
+        parsexyzr p;
+        convergeSpacing(p, cp.filename, study);
+    }
+    else if (cp.thisMode == ELLIP)
+    {
+        parseellipsoid p;
+        convergeSpacing(p, cp.filename, study);
+    }
+    else if (cp.thisMode == SPHCYL)
+    {
+        parsesphcyl p;
+        convergeSpacing(p, cp.filename, study);
+    }
+    else if (cp.thisMode == SUPERQ)
+    {
+        parsesuperquadric p;
+        convergeSpacing(p, cp.filename, study);
+    }
+    else if (cp.thisMode == CLUMP)
+    {
+        parseclump p;
+        convergeSpacing(p, cp.filename, study);
+    }
+    else if (cp.thisMode == MESH)
+    {
+        parsemesh p;
+        convergeSpacing(p, cp.filename, study);
+    }
+    else if (cp.thisMode == TETRA)
+    {
+        parsetetra p;
+        p.parse(cp.filename, pp, cp.shrink, 1);
+        convergeIterations(p, pp, [&](int it, pointpattern& q) { p.sample(q, cp.shrink, it); }, study);
+    }
+    else if (cp.thisMode == TETRABLUNT)
+    {
+        parsetetrablunt p;
+        p.parse(cp.filename, pp, cp.shrink, 1);
+        convergeIterations(p, pp, [&](int it, pointpattern& q) { p.sample(q, cp.shrink, it); }, study);
+    }
+    else if (cp.thisMode == POLYHEDRON)
+    {
+        parsepolyhedron p;
+        p.readparameters(cp.filename);
+        if (cp.shrinkset) p.shrink = cp.shrink;
+        p.depth = 1;
+        p.parse(cp.filename, pp);
+        convergeIterations(p, pp, [&](int it, pointpattern& q) { p.depth = it; p.sample(q); }, study);
+    }
+
+    std::cout << std::endl << study;
+    std::ofstream file(folder + "convergence.dat");
+    if (!file.good())
+    {
+        std::cerr << "error: cannot open convergence file for write" << std::endl;
+        return -1;
+    }
+    file << study;
+    file.close();
+
+    std::ofstream particles(folder + "convergenceParticles.dat");
+    if (!particles.good())
+    {
+        std::cerr << "error: cannot open convergence file for write" << std::endl;
+        return -1;
+    }
+    study.writeparticles(particles);
+    particles.close();
+
+    std::cout << "\nworking for you has been nice. Thank you for using me & see you soon. :) "<< std::endl;
+    return 0;
 }
 
 
@@ -121,6 +548,29 @@ int main (int argc, char* argv[])
     std::cout << "creating Folder for output at " << folder << std::endl;
     mkdir(folder.c_str(),0755);
 
+    if (cp.trajectory)
+    {
+        unsigned int threads = cp.threadsset ? cp.threads : std::thread::hardware_concurrency();
+        trajectory t(cp.thisMode, threads);
+        t.coherent = cp.coherentset;
+        t.threshold = cp.coherent;
+        t.refresh = cp.refresh;
+        return t.run(cp.filename, folder);
+    }
+
+    if (cp.convergeset)
+    {
+        try
+        {
+            return runConvergence(cp, folder);
+        }
+        catch(std::string& e)
+        {
+            std::cerr << e << std::endl;
+            return -1;
+        }
+    }
+
 
 /////////////////////
 // Parameters that are needed
@@ -138,6 +588,10 @@ int main (int argc, char* argv[])
     bool ypbc = false;
     bool zpbc = false;
     output outMode;
+    // sphere radii for the laguerre tessellation (-laguerre), empty for monodisperse spheres
+    std::vector<double> radii;
+    // the points only have x and y, the diagram is calculated in the plane (PLANAR, or planar = true in GENERIC)
+    bool planar = false;
     
 /////////////////////
 // Load Particles in GENERIC Mode
@@ -161,6 +615,7 @@ int main (int argc, char* argv[])
         outMode.saveoff = state["saveoff"];
         outMode.savereduced = state["savereduced"];
         outMode.postprocessing = state["postprocessing"];
+        planar = state["planar"];
         // parse global parameters from lua file
         std::string posfile = state["positionfile"];
         std::string readfile = state["readfile"];
@@ -179,8 +634,18 @@ int main (int argc, char* argv[])
             // create a readstate that translates the particle parameters to surface shapes
             State readstate {true};
             readstate["pointpattern"].SetClass<pointpattern> ("addpoint", &pointpattern::addpoint );
+            readstate["shapekey"].SetClass<shapekey> ("add", &shapekey::add );
+            readstate["rigidtransform"].SetClass<rigidtransform> ("setlabel", &rigidtransform::setlabel, "settranslation", &rigidtransform::settranslation, "setrotation", &rigidtransform::setrotation );
             readstate.Load(readfile);
 
+            // if the read file defines doshape and dopose, every distinct shape is triangulated only once in its body frame
+            // and the particles are created by a rigid transformation of this template
+            bool hasshape = readstate["doshape"];
+            bool haspose = readstate["dopose"];
+            bool hasshapekey = readstate["doshapekey"];
+            bool usetemplates = hasshape && haspose;
+            shapetemplatecache templates;
+            if (usetemplates) std::cout << "using shape templates ... " << std::flush;
 
             for(auto it = setlist.begin(); it != setlist.end(); ++it )
             {
@@ -192,9 +657,29 @@ int main (int argc, char* argv[])
                     readstate["s"][i] = set.get(i);
                 }
 
-                // let the lua readstate calculate the surface triangulation for this particle
-                readstate["docalculation"](pp);
+                if (!usetemplates)
+                {
+                    // let the lua readstate calculate the surface triangulation for this particle
+                    readstate["docalculation"](pp);
+                    continue;
+                }
+
+                shapekey k;
+                if (hasshapekey) readstate["doshapekey"](k);
+                shapetemplate const* s = templates.find(k);
+                if (s == nullptr)
+                {
+                    // first particle with this shape, let the lua readstate calculate the surface triangulation in the body frame
+                    pointpattern body;
+                    readstate["doshape"](body);
+                    s = &templates.insert(k, body);
+                }
+
+                rigidtransform t;
+                readstate["dopose"](t);
+                t.apply(*s, pp);
             }
+            if (usetemplates) std::cout << templates.size() << " distinct shapes ... " << std::flush;
         }
         std::cout << "finished!" << std::endl;
         std::cout << "points created: " << pp.points.size() << std::endl << std::endl;
@@ -242,6 +727,11 @@ int main (int argc, char* argv[])
         outMode.postprocessing = false;
     }
     
+    // the voxel grid takes the shapes of spheres, ellipsoids, spherocylinders and tetrahedra directly from their parsers,
+    // all other particles are rasterized from their surface points
+    unsigned int threads = cp.threadsset ? cp.threads : std::thread::hardware_concurrency();
+    voxelgrid vg(cp.voxel, threads);
+
     if (cp.thisMode == SPHERE)
     {
         parsexyz p;
@@ -262,7 +752,9 @@ int main (int argc, char* argv[])
     {
         parsexyzr p;
         std::cout << "loading file: " << cp.filename << std::endl;
+        p.centersonly = cp.laguerre || cp.quadratureset || cp.voxelset;
         p.parse(cp.filename, pp);
+        radii = p.radii;
         outMode.postprocessing = false; 
 
         xmin = p.xmin;
@@ -274,10 +766,21 @@ int main (int argc, char* argv[])
         xpbc = p.xpbc;
         ypbc = p.ypbc;
         zpbc = p.zpbc;
+
+        if (cp.voxelset)
+        {
+            vg.setup(xmin, xmax, ymin, ymax, zmin, zmax, xpbc, ypbc, zpbc);
+            for (size_t i = 0; i != p.spheres.size(); ++i)
+            {
+                xyzrsphere const& s = p.spheres[i];
+                vg.addsphere(i+1, s.x, s.y, s.z, s.r);
+            }
+        }
     }
     else if (cp.thisMode == ELLIP)
     {
         parseellipsoid p;
+        p.shapesonly = cp.voxelset;
         p.parse(cp.filename, pp);
         outMode.postprocessing = false; 
     
@@ -292,12 +795,27 @@ int main (int argc, char* argv[])
         ypbc = p.ypbc;
         zpbc = p.zpbc;
 
+        // with steps = 1 the ellipsoids stand for their centers, these are rasterized as points below
+        if (cp.voxelset && p.steps == 1) p.sample(pp);
+        if (cp.voxelset && p.steps != 1)
+        {
+            vg.setup(xmin, xmax, ymin, ymax, zmin, zmax, xpbc, ypbc, zpbc);
+            for (ellip const& e : p.ellipsoids)
+            {
+                rigidtransform t;
+                t.setrotation(e.x1, e.y1, e.z1, e.x2, e.y2, e.z2, e.x3, e.y3, e.z3);
+                t.settranslation(e.cx, e.cy, e.cz);
+                vg.addellipsoid(e.l, t, e.a, e.b, e.c);
+            }
+        }
+
     }
     else if (cp.thisMode == TETRA)
     {
         parsetetra p;
         double shrink = cp.shrink;
         int iterations = cp.iterations;
+        p.shapesonly = cp.voxelset;
         p.parse(cp.filename, pp, shrink, iterations);
         outMode.postprocessing = false; 
         std::cout << "epsilon " << epsilon << std::endl;
@@ -310,6 +828,17 @@ int main (int argc, char* argv[])
         xpbc = p.xpbc;
         ypbc = p.ypbc;
         zpbc = p.zpbc;
+
+        if (cp.voxelset)
+        {
+            vg.setup(xmin, xmax, ymin, ymax, zmin, zmax, xpbc, ypbc, zpbc);
+            // shrunk about their centers as for the surface points
+            for (std::vector<point> t : p.tetrahedra)
+            {
+                parsetetra::dumbShrink(t, shrink);
+                vg.addtetrahedron(t[0].l, t);
+            }
+        }
     }
     else if (cp.thisMode == TETRABLUNT)
     {
@@ -329,12 +858,11 @@ int main (int argc, char* argv[])
         ypbc = p.ypbc;
         zpbc = p.zpbc;
     }
-    else if (cp.thisMode == SPHCYL)
+    else if (cp.thisMode == SUPERQ)
     {
-
-        parsesphcyl p;
+        parsesuperquadric p;
         p.parse(cp.filename, pp);
-
+        outMode.postprocessing = false; 
         xmin = p.xmin;
         ymin = p.ymin;
         zmin = p.zmin;
@@ -345,332 +873,273 @@ int main (int argc, char* argv[])
         ypbc = p.ypbc;
         zpbc = p.zpbc;
     }
-
-
-    // clean degenerated vertices from particle surface triangulation pointpattern
+    else if (cp.thisMode == CLUMP)
     {
-        std::cout << "remove duplicates in surface triangulation" << std::endl;
-        duplicationremover d(40,40,40);
-        d.setboundaries(xmin, xmax, ymin, ymax, zmin, zmax);
-        d.addPoints(pp);
-        d.removeduplicates(epsilon);
-        d.getallPoints(pp);
-        std::cout << std::endl;
+        parseclump p;
+        p.parse(cp.filename, pp);
+        outMode.postprocessing = false; 
+        xmin = p.xmin;
+        ymin = p.ymin;
+        zmin = p.zmin;
+        xmax = p.xmax;
+        ymax = p.ymax;
+        zmax = p.zmax;
+        xpbc = p.xpbc;
+        ypbc = p.ypbc;
+        zpbc = p.zpbc;
     }
-    // print out pointpattern file
-    if (outMode.savesurface == true)
+    else if (cp.thisMode == MESH)
     {
-        std::cout << "save surface triangulation file" << std::endl;
-        std::ofstream file;
-        file.open(folder + "surface_triangulation.xyz");
-        file << pp;
-        file.close();
-    }
-    std::cout << std::endl;
-
-
-    // add particle surface triangulation to voro++ pre container for subcell division estimate
-    std::cout << "importing surface triangulation to voro++" << std::endl;
-
-    pre_container pcon(xmin, xmax, ymin, ymax, zmin, zmax, xpbc, ypbc, zpbc);
-    
-    // label ID map is used to  map surface point IDs to the respective particle label
-    std::cout << "creating label id map " ;
-    std::map < unsigned long long, unsigned long long > labelidmap;
-    // volumemap is a map from particlelabel to voronoi cell volume
-    std::vector <double> volumeMap;
-    unsigned long long maxParticleLabel = 0;
-    std::vector<std::vector<double> > ref;
-    {
-        unsigned long long id = 0;
-        for(    auto it = pp.points.begin();
-                it != pp.points.end();
-                ++it)
-        {
-            pcon.put(id, it->x, it->y, it->z);
-            unsigned int l = it->l;
-            labelidmap[id] = l;
-            if (l > maxParticleLabel) maxParticleLabel =l;
-            
-            ++id;
-            if(ref.size() < l+1) ref.resize(l+1);
-            if(ref[l].size() == 0)
-            {
-                ref[l].push_back(it->x);
-                ref[l].push_back(it->y);
-                ref[l].push_back(it->z);
-                ref[l].push_back(0);
-                ref[l].push_back(0);
-                ref[l].push_back(0);
-            }
-        }
+        parsemesh p;
+        p.parse(cp.filename, pp);
+        outMode.postprocessing = false; 
+        xmin = p.xmin;
+        ymin = p.ymin;
+        zmin = p.zmin;
+        xmax = p.xmax;
+        ymax = p.ymax;
+        zmax = p.zmax;
+        xpbc = p.xpbc;
+        ypbc = p.ypbc;
+        zpbc = p.zpbc;
     }
-    unsigned long long numberofpoints = labelidmap.size();
-    
-    if (outMode.postprocessing == true)
+    else if (cp.thisMode == PLANAR)
     {
-
-        volumeMap.resize(maxParticleLabel+1, 0);
+        parseplanar p;
+        p.parse(cp.filename, pp);
+        planar = true;
+        xmin = p.xmin;
+        ymin = p.ymin;
+        zmin = p.zmin;
+        xmax = p.xmax;
+        ymax = p.ymax;
+        zmax = p.zmax;
+        xpbc = p.xpbc;
+        ypbc = p.ypbc;
+        zpbc = p.zpbc;
     }
-
-    std::cout << "finished" << std::endl;
-    
-    std::cout << "clear Surface Triangulation ... ";
-
-    pp.clear();
-
-    std::cout << "done" << std::endl;
-
-
-
-    // setting up voro++ container
-    int nx, ny, nz;
-    pcon.guess_optimal(nx,ny,nz);
-    container con(xmin, xmax, ymin, ymax, zmin, zmax, nx, ny, nz, xpbc, ypbc, zpbc, 8);
-    pcon.setup(con);
-    std::cout << "setting up voro++ container with division: (" << nx << " " << ny << " " << nz << ") for N= " << numberofpoints << " particles " << std::endl;
-    std::cout << std::endl;
-
-    // postprocessing for normal voronoi Output
-    if(outMode.postprocessing == true)
+    else if (cp.thisMode == IMAGE)
     {
-
-        std::cout << "Performing Postprocessing for normal (unmerged) Voronoi Cells" << std::endl;
-
-        std::string customFileName = folder + "custom.dat";
-        con.print_custom("%i %s %v", customFileName.c_str());
-        DoPostProcessing(folder);
+        parseimage p;
+        p.parse(cp.filename, pp);
+        outMode.postprocessing = false; 
+        xmin = p.xmin;
+        ymin = p.ymin;
+        zmin = p.zmin;
+        xmax = p.xmax;
+        ymax = p.ymax;
+        zmax = p.zmax;
+        xpbc = p.xpbc;
+        ypbc = p.ypbc;
+        zpbc = p.zpbc;
     }
-    else
+    else if (cp.thisMode == POLYHEDRON)
     {
-        std::cout << "skipping postprocessing" << std::endl;
+        parsepolyhedron p;
+        p.readparameters(cp.filename);
+        if (cp.shrinkset) p.shrink = cp.shrink;
+        if (cp.itset) p.depth = cp.iterations;
+        p.parse(cp.filename, pp);
+        outMode.postprocessing = false; 
+        xmin = p.xmin;
+        ymin = p.ymin;
+        zmin = p.zmin;
+        xmax = p.xmax;
+        ymax = p.ymax;
+        zmax = p.zmax;
+        xpbc = p.xpbc;
+        ypbc = p.ypbc;
+        zpbc = p.zpbc;
     }
-    std::cout << std::endl;
-    
-    // merge voronoi cells to set voronoi diagram
-    std::cout << "merge voronoi cells ";
-    
-    pointpattern ppreduced;
-    writerpoly pw;
-    // loop over all voronoi cells
-    c_loop_all cla(con);
-    // cell currently worked on
-    unsigned long long status = 0;
-    // counter for process output
-    double tenpercentSteps = 0.01*static_cast<double>(numberofpoints);
-    double target = tenpercentSteps;
-
-    double xdist = xmax - xmin;
-    double ydist = ymax - ymin;
-    double zdist = zmax - zmin;
-
-    //unsigned long long refl = 0;
-
-    if(cla.start())
+    else if (cp.thisMode == SPHCYL)
     {
-        std::cout << "started\n" << std::flush;
-        do
-        {
-            voronoicell_neighbor c;
-            status++;
-            if(con.compute_cell(c,cla))
-            {
-                if ( status >= target)
-                {
-                    target += tenpercentSteps;
-                    std::cout << static_cast<int>(static_cast<double>(status)/static_cast<double>(numberofpoints)*100) << " \% " << std::flush;
-                }
-                //std::cout << "computed"  << std::endl;
-                double xc = 0;
-                double yc = 0;
-                double zc = 0;
-                // Get the position of the current particle under consideration
-                cla.pos(xc,yc,zc);
-                
-
-
-                unsigned int id = cla.pid();
-                unsigned long long l = labelidmap[id];
-                if (outMode.postprocessing == true)
-                {
-                    volumeMap[l] += c.volume();  
-                }
-                double xabs = (xc-ref[l][0]);
-                double yabs = (yc-ref[l][1]);
-                double zabs = (zc-ref[l][2]);
-
-                double xabs2 = xabs*xabs;
-                double yabs2 = yabs*yabs;
-                double zabs2 = zabs*zabs;
 
-                double xabs_alt, yabs_alt, zabs_alt;
-                double xabs2_alt, yabs2_alt, zabs2_alt;
-
-                ref[l][3]=0;
-                if(xpbc)
-                {
-                    if(xabs < 0) xabs_alt = xabs + xdist;
-                    else xabs_alt = xabs - xdist;
-                    
-                    xabs2_alt = xabs_alt*xabs_alt;
-
-                    if(xabs2 < xabs2_alt) ref[l][3] = 0;
-                    else
-                    { 
-                        if(xabs < 0) ref[l][3] = xdist;
-                        else ref[l][3] = -xdist;
-                    }
-                }
-                ref[l][4]=0;
-                if(ypbc)
-                {
-                    if(yabs < 0) yabs_alt = yabs + ydist;
-                    else yabs_alt = yabs - ydist;
-                    
-                    yabs2_alt = yabs_alt*yabs_alt;
-
-                    if(yabs2 < yabs2_alt) ref[l][4] = 0;
-                    else
-                    { 
-                        if(yabs < 0) ref[l][4] = ydist;
-                        else ref[l][4] = -ydist;
-                    }
-                }
-                ref[l][5]=0;
-                if(zpbc)
-                {
-                    if(zabs < 0) zabs_alt = zabs + zdist;
-                    else zabs_alt = zabs - zdist;
-                    
-                    zabs2_alt = zabs_alt*zabs_alt;
-
-                    if(zabs2 < zabs2_alt) ref[l][5] = 0;
-                    else
-                    { 
-                        if(zabs < 0) ref[l][5] = zdist;
-                        else ref[l][5] = -zdist;
-                    }
-                }
-
-                std::vector<int> f; // list of face vertices (bracketed, as ID)
-                c.face_vertices(f);
-
-                std::vector<double> vertices;   // all vertices for this cell
-                c.vertices(xc,yc,zc, vertices);
+        parsesphcyl p;
+        p.shapesonly = cp.voxelset;
+        p.parse(cp.filename, pp);
 
-                std::vector<int> w; // neighbors of faces
-                c.neighbors(w);
-                // for this cell, loop over all faces and get the corresponding neighbors
-                for (unsigned long long k = 0; k != w.size(); ++k)
-                {
-                    // compare if id for this cell and the face-neighbor is the same
-                    int n = w[k];   // ID of neighbor cell
-                    if (labelidmap[n] == l)
-                    {
-                        // discard this neighbour/face, since they have the same id
-                        //std::cout << "discarding face " << l << " " << labelidmap[n] << std::endl;
-
-                    }
-                    else
-                    {
-                        std::vector<unsigned int> facevertexlist;
-                        getFaceVerticesOfFace(f, k, facevertexlist);
-                        std::vector<double> positionlist;
-                        for (
-                            auto it = facevertexlist.begin();
-                            it != facevertexlist.end();
-                            ++it)
-                        {
-                            unsigned int vertexindex = (*it);
-                            double x = vertices[vertexindex*3];
-                            double y = vertices[vertexindex*3+1];
-                            double z = vertices[vertexindex*3+2];
-
-                            if(xpbc) x += ref[l][3];
-                            if(ypbc) y += ref[l][4];
-                            if(zpbc) z += ref[l][5];
-
-                            ppreduced.addpoint(l,x,y,z);
-                            positionlist.push_back(x);
-                            positionlist.push_back(y);
-                            positionlist.push_back(z);
-                        }
-                        pw.addface(positionlist, l);
-
-                    }
-                }
+        xmin = p.xmin;
+        ymin = p.ymin;
+        zmin = p.zmin;
+        xmax = p.xmax;
+        ymax = p.ymax;
+        zmax = p.zmax;
+        xpbc = p.xpbc;
+        ypbc = p.ypbc;
+        zpbc = p.zpbc;
 
-            }
+        if (cp.voxelset)
+        {
+            vg.setup(xmin, xmax, ymin, ymax, zmin, zmax, xpbc, ypbc, zpbc);
+            for (sphcylinder const& c : p.spherocylinders) vg.addspherocylinder(c.t.l, c.t, c.r, c.l);
         }
-        while (cla.inc());
     }
-    std::cout << std::endl << " finished with N= " << ppreduced.points.size() << std::endl;
-    std::cout << std::endl;
 
-    con.clear();
 
-    if(outMode.postprocessing == true)
+    // set voronoi diagram in the plane, cell areas and edge lengths take the place of volumes and face areas
+    if (planar)
     {
-        std::cout << "save set voronoi cell volumes" << std::endl;
-        // save set voronoi volumes
-        std::ofstream out(folder+"setVoronoiVolumes.dat");
-        out << "#1_particle label #2_set voronoi cell volume\n";
-        for (unsigned long long i = 0; i != volumeMap.size(); ++i)
+        std::cout << "calculating 2d set voronoi diagram" << std::endl;
+        pomelobox box = {xmin, xmax, ymin, ymax, zmin, zmax, xpbc, ypbc, zpbc};
+        pomelooptions options;
+        options.verbose = true;
+        options.mesh = outMode.savepoly;
+        std::vector<double> xy;
+        std::vector<int> labels;
+        toarrays(pp, true, xy, labels);
+        pomeloresult result;
+        try
         {
-            out << i << " " << std::setprecision(12) << volumeMap[i] << "\n";
+            pomelocalculate2d(xy, labels, box, options, result);
         }
-        out.close();
+        catch (std::string& e)
+        {
+            std::cerr << e << std::endl;
+            return -1;
+        }
+        saveVolumes(result.volume, folder);
+        saveFaces(facemaps(result), folder);
+        if (outMode.savepoly)
+        {
+            std::cout << "writing 2d cells: " << folder + "cell.xy" << std::endl;
+            saveOutlines(result, folder + "cell.xy");
+        }
+        std::cout << "\nworking for you has been nice. Thank you for using me & see you soon. :) "<< std::endl;
+        return 0;
+    }
 
-    } 
+    // fast path for spheres: one cell per particle, no surface triangulation
+    if (cp.laguerre)
+    {
+        std::cout << "calculating " << (radii.empty() ? "voronoi" : "laguerre") << " tessellation of the sphere centers" << std::endl;
+        laguerre lt;
+        writerpoly pw;
+        outMode.postprocessing = !cp.polyswitch;
+        if (outMode.postprocessing == true) lt.customfile = folder + "custom.dat";
+        lt.calculate(pp, radii, xmin, xmax, ymin, ymax, zmin, zmax, xpbc, ypbc, zpbc, pw);
+        pp.clear();
+        if (outMode.postprocessing == true)
+        {
+            std::cout << "Performing Postprocessing for the Voronoi Cells" << std::endl;
+            DoPostProcessing(folder);
+            saveFaces(lt.facearea, folder);
+        }
+        return saveCells(pw, lt.volume, pw.p.points.size(), outMode, folder, epsilon, xmin, xmax, ymin, ymax, zmin, zmax, lt.nx, lt.ny, lt.nz);
+    }
 
-    if (ppreduced.points.size() == 0)
+    // approximate set voronoi diagram on a voxel grid
+    if (cp.voxelset)
     {
-        std::cout << "\nall Voronoi Vertices have been removed. Check for periodic boundary conditions. skipping further calculation." << std::endl;
+        std::cout << "calculating set voronoi diagram on a voxel grid" << std::endl;
+        if (!vg.ready())
+        {
+            vg.setup(xmin, xmax, ymin, ymax, zmin, zmax, xpbc, ypbc, zpbc);
+            vg.addpoints(pp);
+        }
+        pp.clear();
+        vg.calculate();
+        saveVolumes(vg.volume, folder);
+        saveFaces(vg.facearea, folder);
         std::cout << "\nworking for you has been nice. Thank you for using me & see you soon. :) "<< std::endl;
         return 0;
     }
-    // save point pattern output
-    if(outMode.savereduced == true)
+
+    // set voronoi diagram of spheres by quadrature, no surface triangulation
+    if (cp.quadratureset)
     {
-        pw.savePointPatternForGnuplot(folder + "reduced.xyz");
-    }
+        std::cout << "calculating set voronoi diagram of the spheres by quadrature" << std::endl;
+        quadraturespheres es(cp.quadrature, cp.meshdepth);
+        writerpoly pw;
+        es.calculate(pp, radii, xmin, xmax, ymin, ymax, zmin, zmax, xpbc, ypbc, zpbc, pw);
+        pp.clear();
 
-    std::cout << std::endl;
-    // remove duplicates and label back indices
-    pw.removeduplicates(epsilon, xmin, xmax, ymin, ymax, zmin, zmax, nx, ny, nz);
+        saveFaces(es.facearea, folder);
 
-    std::cout << std::endl;
-    // Write poly file for karambola
-    if(outMode.savepoly == true)
+        outMode.postprocessing = true;
+        if (cp.meshdepth > 0)
+        {
+            return saveCells(pw, es.volume, pw.p.points.size(), outMode, folder, epsilon, xmin, xmax, ymin, ymax, zmin, zmax, es.nx, es.ny, es.nz);
+        }
+        saveVolumes(es.volume, folder);
+        std::cout << "\nworking for you has been nice. Thank you for using me & see you soon. :) "<< std::endl;
+        return 0;
+    }
+
+    // point location only needs the surface points, duplicates do not change the nearest one
+    if (cp.locateset)
     {
-        std::cout << "writing poly file: " << folder + "cell.poly" << std::endl;
-        std::ofstream file;
+        return saveLocations(pp, cp.locate, cp.threads, folder, xmin, xmax, ymin, ymax, zmin, zmax, xpbc, ypbc, zpbc);
+    }
 
-        file.open(folder + "cell.poly");
-        if (!file.good())
+    // the set voronoi diagram of the surface points is calculated by libpomelo (libpomelo.hpp)
+    pomelobox box = {xmin, xmax, ymin, ymax, zmin, zmax, xpbc, ypbc, zpbc};
+    pomelooptions options;
+    options.epsilon = epsilon;
+    options.verbose = true;
+    options.mesh = outMode.savepoly || outMode.saveoff || outMode.savereduced;
+    options.cells = outMode.postprocessing || outMode.savesurface;
+    if (cp.tiltset)
+    {
+        if (!xpbc || !ypbc || !zpbc)
         {
-            std::cerr << "error: cannot open poly file for write" << std::endl;
-            throw std::string("error: cannot open poly file for write");
+            std::cerr << "tilt needs periodic boundaries in all directions" << std::endl;
+            return -1;
         }
-        file << pw;
-        file.close();
+        options.triclinic = true;
+        options.xy = cp.tilt[0];
+        options.xz = cp.tilt[1];
+        options.yz = cp.tilt[2];
+        std::cout << "triclinic box with tilt " << options.xy << " " << options.xz << " " << options.yz << std::endl;
     }
-    if(outMode.saveoff == true)
+
+    // only the cells of the selected particles (-select, -region)
+    std::vector<bool> selection;
+    if (cp.selectset || cp.regionset)
     {
-        std::cout << "writing off file" << std::endl;
-        std::ofstream file;
-        file.open(folder+"cell.off");
-        if (!file.good())
+        particleselection ps;
+        try
         {
-            std::cerr << "error: cannot open off file for write" << std::endl;
-            throw std::string("error: cannot open off file for write");
+            if (cp.selectset) ps.parselabels(cp.select);
+        }
+        catch (std::string& e)
+        {
+            std::cerr << e << std::endl;
+            return -1;
+        }
+        catch (std::exception& e)
+        {
+            std::cerr << "cannot parse selected labels " << cp.select << std::endl;
+            return -1;
+        }
+        ps.region = cp.region;
+        ps.bounds = cp.regionbounds;
+        selection = ps.select(pp, xmin, xmax, ymin, ymax, zmin, zmax, xpbc, ypbc, zpbc);
+        for (size_t l = 0; l != selection.size(); ++l)
+        {
+            if (selection[l]) options.selected.push_back(static_cast<int>(l));
+        }
+        std::cout << "selected " << options.selected.size() << " particles" << std::endl << std::endl;
+        if (options.selected.empty())
+        {
+            std::cerr << "no particle is selected" << std::endl;
+            return -1;
         }
-        writeroff wo(pw);
-        file << wo;
-        file.close();
     }
 
-    std::cout << "\nworking for you has been nice. Thank you for using me & see you soon. :) "<< std::endl;
-
-    return 0;
+    std::vector<double> xyz;
+    std::vector<int> labels;
+    toarrays(pp, false, xyz, labels);
+    pomeloresult result;
+    try
+    {
+        pomelocalculate(xyz, labels, box, options, result);
+    }
+    catch (std::string& e)
+    {
+        std::cerr << e << std::endl;
+        return -1;
+    }
+    std::vector<double>().swap(xyz);
+    std::vector<int>().swap(labels);
+    return saveResult(result, outMode, folder, selection);
 }
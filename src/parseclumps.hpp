@@ -0,0 +1,284 @@
+/* 
+Copyright 2016 Simon Weis and Philipp Schoenhoefer
+
+This file is part of Pomelo.
+
+Pomelo is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Pomelo is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Pomelo.  If not, see <http://www.gnu.org/licenses/>.
+
+The development of Pomelo took place at the Friedrich-Alexander University of Erlangen and was funded by the German Research Foundation (DFG) Forschergruppe FOR1548 "Geometry and Physics of Spatial Random Systems" (GPSRS). 
+*/
+#ifndef PARSECLUMPS_H_GUARD_123456
+#define PARSECLUMPS_H_GUARD_123456
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include "pointpattern.hpp"
+#include "splitstring.hpp"
+#include "shapetemplate.hpp"
+#include "spheresampling.hpp"
+#include "adaptivesampling.hpp"
+#include "vec3.hpp"
+
+// one sphere of a clump in the body frame
+struct clumpsphere
+{
+    vec3 c;
+    double r;
+};
+
+// one grain: the clump it is made of and its pose
+struct clumpparticle
+{
+    std::string clump;
+    int label;
+    double x, y, z;
+    double a11, a12, a13, a21, a22, a23, a31, a32, a33;
+};
+
+
+// rigid clumps of overlapping spheres that are defined once per clump and instanced per particle
+// the file consists of # comment lines with the parameters, the clump definitions and the particles:
+//   # boundary_condition = periodic_cuboidal, boxsz = 10, shrink = 0.01, spacing = 0.05
+//   clump dimer
+//   s -0.3 0 0 0.5
+//   s 0.3 0 0 0.5
+//   dimer 1 x y z a11 a12 a13 a21 a22 a23 a31 a32 a33
+// a body-frame point v of particle (label 1) is placed at R v + (x, y, z) with the rotation matrix R given row by row
+class parseclump
+{
+public:
+    double xmin;
+    double ymin;
+    double zmin;
+    double xmax;
+    double ymax;
+    double zmax;
+    double shrink;      // distance by which the radii of all spheres are reduced
+    samplingdensity density;    // spacing of the surface points, a fifth of the smallest radius of the clump if not set
+    samplingdensity forceddensity;  // replaces the density of the input file if set, used for the levels of the convergence study
+    bool boxset;
+    std::map<std::string, std::vector<clumpsphere> > clumps;   // body frame spheres of every clump by name
+    std::vector<clumpparticle> particles;
+    bool xpbc;
+    bool ypbc;
+    bool zpbc;
+
+    parseclump () : xmin(0),  ymin(0), zmin(0), xmax(0) ,ymax(0), zmax(0), shrink(0), boxset(false), xpbc(false), ypbc(false), zpbc(false)
+    {};
+
+    void parse(std::string const filename, pointpattern& pp)
+    {
+        std::cout << "parse clump file" << std::endl;
+        std::ifstream infile;
+        infile.open(filename);
+        if (infile.fail())
+        {
+            throw std::string("cannot open clump input file");
+        }
+        std::string line = "";
+        std::vector<clumpsphere>* current = nullptr;
+
+        while(std::getline(infile, line))   // parse lines
+        {
+            if(line.find('#') != std::string::npos)
+            {
+                parseparameters(line);
+                continue;
+            }
+            std::istringstream iss(line);
+            std::string key;
+            if (!(iss >> key)) continue;
+
+            if (key == "clump")
+            {
+                std::string name;
+                if (!(iss >> name)) throw std::string("clump without a name in clump file");
+                if (clumps.count(name) != 0) throw std::string("clump " + name + " is defined twice");
+                current = &clumps[name];
+                continue;
+            }
+            if (key == "s")
+            {
+                clumpsphere s;
+                if (current == nullptr || !(iss >> s.c.x >> s.c.y >> s.c.z >> s.r)) throw std::string("cannot parse sphere line in clump file: " + line);
+                current->push_back(s);
+                continue;
+            }
+
+            current = nullptr;
+            clumpparticle p;
+            p.clump = key;
+            if (!(iss >> p.label >> p.x >> p.y >> p.z >> p.a11 >> p.a12 >> p.a13 >> p.a21 >> p.a22 >> p.a23 >> p.a31 >> p.a32 >> p.a33))
+            {
+                std::cerr << "error parsing one line in clump file" << std::endl;
+                std::cout << line << std::endl;
+                break;
+            }
+            particles.push_back(p);
+        }
+        if ((xpbc || ypbc || zpbc) && !boxset)
+            throw std::string("periodic boundaries need the boxsz parameter in the clump file");
+        sample(pp);
+
+        std::cout << "parsed "  << particles.size() << " particles of " << templates.size() << " clumps" << std::endl;
+        std::cout << "created N = " << pp.points.size() << " points"  << std::endl;
+        if (pp.points.empty()) throw std::string("no particles in clump file");
+
+        if (!boxset)
+        {
+            std::cout << "setting boundaries "<< std::endl;
+            xmin = ymin = zmin = std::numeric_limits<double>::max();
+            xmax = ymax = zmax = std::numeric_limits<double>::lowest();
+            for (point const& p : pp.points)
+            {
+                xmin = std::min(xmin, p.x); xmax = std::max(xmax, p.x);
+                ymin = std::min(ymin, p.y); ymax = std::max(ymax, p.y);
+                zmin = std::min(zmin, p.z); zmax = std::max(zmax, p.z);
+            }
+        }
+    };
+
+    // surface points of the parsed particles, called again after changing forceddensity to resample them without reading the file
+    void sample(pointpattern& pp)
+    {
+        if (forceddensity.active()) density = forceddensity;
+
+        // the surface of every clump is created once, on first use
+        templates.clear();
+        for (clumpparticle const& p : particles)
+        {
+            auto it = templates.find(p.clump);
+            if (it == templates.end())
+            {
+                auto c = clumps.find(p.clump);
+                if (c == clumps.end()) throw std::string("unknown clump " + p.clump + " in clump file");
+                it = templates.insert(std::make_pair(p.clump, createtemplate(c->second))).first;
+                std::cout << "clump " << p.clump << ": " << it->second.size() << " surface points" << std::endl;
+            }
+
+            rigidtransform t;
+            t.setlabel(p.label);
+            t.setorthonormalrotation(p.a11, p.a12, p.a13, p.a21, p.a22, p.a23, p.a31, p.a32, p.a33);
+            t.settranslation(p.x, p.y, p.z);
+            t.apply(it->second, pp);
+        }
+    };
+
+private:
+    std::map<std::string, shapetemplate> templates;
+
+    void parseparameters(std::string const& line)
+    {
+        splitstring commentline(line.substr(line.find('#') + 1).c_str());
+        std::vector<std::string> parameters = commentline.split(',');
+        for (auto s:parameters)
+        {
+            if (s.find('=') == std::string::npos) continue;
+            splitstring split (s.c_str());
+            std::vector<std::string> valuesplit = split.split('=');
+            if (valuesplit.size() != 2)
+                throw std::string("cannot parse parameters from clump file");
+
+            if (s.find("boxsz") != std::string::npos)
+            {
+                double v = std::stod(valuesplit[1]);
+                std::cout << "clump parser boxsize: " << v << std::endl;
+                xmin = ymin = zmin = 0;
+                xmax = ymax = zmax = v;
+                boxset = true;
+            }
+            else if (s.find("boundary_condition") != std::string::npos)
+            {
+                if (valuesplit[1].find("periodic_cuboidal") != std::string::npos)
+                {
+                    xpbc = ypbc = zpbc = true;
+                    std::cout << "clump parser boundaries: " << valuesplit[1] << std::endl;
+                }
+            }
+            else if (s.find("shrink") != std::string::npos)
+            {
+                shrink = std::stod(valuesplit[1]);
+                std::cout << "loaded a shrink value of " << shrink << std::endl;
+            }
+            else if (s.find("spacing") != std::string::npos)
+            {
+                density.spacing = std::stod(valuesplit[1]);
+                std::cout << "spacing: " << density.spacing << std::endl;
+            }
+            else if (s.find("tolerance") != std::string::npos)
+            {
+                density.tolerance = std::stod(valuesplit[1]);
+                std::cout << "tolerance: " << density.tolerance << std::endl;
+            }
+        }
+    };
+
+    // exposed surface of one clump: every sphere is sampled on a fibonacci lattice and the points
+    // that lie inside one of its overlapping siblings are dropped
+    shapetemplate createtemplate(std::vector<clumpsphere> const& spheres) const
+    {
+        if (spheres.empty()) throw std::string("a clump needs at least one sphere");
+        std::vector<clumpsphere> shrunk = spheres;
+        double rmin = std::numeric_limits<double>::max();
+        for (clumpsphere& s : shrunk)
+        {
+            s.r -= shrink;
+            if (s.r <= 0) throw std::string("clump shrink is larger than the radius of a sphere");
+            rmin = std::min(rmin, s.r);
+        }
+
+        shapetemplate st;
+        for (size_t i = 0; i != shrunk.size(); ++i)
+        {
+            clumpsphere const& s = shrunk[i];
+            double h = density.active() ? density.at(s.r) : 0.2*rmin;
+
+            // only the siblings that overlap with this sphere can hide some of its points
+            std::vector<clumpsphere> siblings;
+            for (size_t j = 0; j != shrunk.size(); ++j)
+            {
+                if (j == i) continue;
+                vec3 d = shrunk[j].c - s.c;
+                if (d.length() < shrunk[j].r + s.r) siblings.push_back(shrunk[j]);
+            }
+
+            std::vector<vec3> unit = fibonaccisphere(pointsforspacing(4.0*M_PI*s.r*s.r, h));
+            for (vec3 const& u : unit)
+            {
+                vec3 p = s.c + u*s.r;
+                bool hidden = false;
+                for (clumpsphere const& o : siblings)
+                {
+                    vec3 d = p - o.c;
+                    if (dot(d, d) < o.r*o.r*(1.0 - 1e-12))
+                    {
+                        hidden = true;
+                        break;
+                    }
+                }
+                if (!hidden) st.addpoint(p.x, p.y, p.z);
+            }
+        }
+        return st;
+    };
+};
+
+#endif
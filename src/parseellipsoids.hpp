@@ -29,7 +29,9 @@ The development of Pomelo took place at the Friedrich-Alexander University of Er
 #include <algorithm>
 #include "pointpattern.hpp"
 #include "splitstring.hpp"
-#include "GenericMatrix.h"
+#include "shapetemplate.hpp"
+#include "vec3.hpp"
+#include "adaptivesampling.hpp"
 
 struct ellip
 {
@@ -53,24 +55,35 @@ public:
     double zmax;
     double shrink;
     unsigned int steps;
+    samplingdensity density;    // if set, the spacing of the surface points follows the local curvature instead of the steps
+    samplingdensity forceddensity;  // replaces the density of the input file if set, used for the levels of the convergence study
+    bool shapesonly;    // only store the ellipsoids without spawning surface points, used for the voxel grid
     bool xpbc;
     bool ypbc;
     bool zpbc;
+    bool verbose;
 
     std::vector<ellip> ellipsoids;
     
 
-    parseellipsoid () : xmin(0),  ymin(0), zmin(0), xmax(0) ,ymax(0), zmax(0), shrink (0), steps(10), xpbc(false), ypbc(false), zpbc(false)
+    parseellipsoid () : xmin(0),  ymin(0), zmin(0), xmax(0) ,ymax(0), zmax(0), shrink (0), steps(10), shapesonly(false), xpbc(false), ypbc(false), zpbc(false), verbose(true)
     {};
     void parse(std::string const filename, pointpattern& pp)
     {
-        std::cout << "parse ellip file" << std::endl;
+        if (verbose) std::cout << "parse ellip file" << std::endl;
         std::ifstream infile;
         infile.open(filename);
         if (infile.fail())
         {
             throw std::string("cannot open ellip input file");
         }
+        parse(infile, pp);
+    };
+
+    // the whole stream is one frame (used for trajectories), the ellipsoids of the last call are replaced
+    void parse(std::istream& infile, pointpattern& pp)
+    {
+        ellipsoids.clear();
         std::string line = "";
         unsigned long linesloaded = 0;
 
@@ -111,6 +124,28 @@ public:
                     double v = std::stod(boxsplit[1]);
                     zmax = static_cast<int>(v);
                 }
+                if (line.find("spacing") != std::string::npos)
+                {
+                    splitstring split (line.c_str());
+                    std::vector<std::string> boxsplit= split.split('=');
+                    if (boxsplit.size() != 2)
+                    {
+                        throw std::string ("cannot parse spacing parameter.");
+                    }
+                    density.spacing = std::stod(boxsplit[1]);
+                    if (verbose) std::cout << "spacing: " << density.spacing << std::endl;
+                }
+                if (line.find("tolerance") != std::string::npos)
+                {
+                    splitstring split (line.c_str());
+                    std::vector<std::string> boxsplit= split.split('=');
+                    if (boxsplit.size() != 2)
+                    {
+                        throw std::string ("cannot parse tolerance parameter.");
+                    }
+                    density.tolerance = std::stod(boxsplit[1]);
+                    if (verbose) std::cout << "tolerance: " << density.tolerance << std::endl;
+                }
                 if (line.find("steps") != std::string::npos)
                 {
                     splitstring split (line.c_str());
@@ -134,18 +169,14 @@ public:
                 break;
             }
             linesloaded++;
-            if (steps == 1)
-            {
-                pp.addpoint(e.l, e.cx, e.cy, e.cz);
-                continue;
-            }
-            else
-            {
-                ellipsoids.push_back(e);
-            }
+            ellipsoids.push_back(e);
         }
 
-        if (steps == 1) return;
+        if (steps == 1 || shapesonly)
+        {
+            if (!shapesonly) sample(pp);
+            return;
+        }
         
         // calc shrink automatically
 
@@ -164,73 +195,121 @@ public:
 
         // formula by fabian... need to check this
         shrink = 0.95 * std::pow(e0mean * e1mean * e2mean * 0.4 * 0.4 , 1./3.) * 0.4;
-        std::cout << "shrink corresponds to aspect ratio = 0.4" << std::endl;
-        std::cout << "shrink = " << shrink << std::endl;
+        if (verbose) std::cout << "shrink corresponds to aspect ratio = 0.4" << std::endl;
+        if (verbose) std::cout << "shrink = " << shrink << std::endl;
+        sample(pp);
+        if (verbose) std::cout << "parsed "  << linesloaded << " lines" << std::endl;
+
+        if (verbose) std::cout << "created N = " << pp.points.size() << " points"  << std::endl;
+        if (verbose) std::cout << "setting boundaries "<< std::endl;
+        //std::cout << "\t nx="<< nx << std::endl;
+        //std::cout << "\t nx="<< ny << std::endl;
+        //std::cout << "\t nx="<< nz << std::endl;
+        
+        xmin = 0;
+        ymin = 0;
+        zmin = 0;
+    };
+
+    // surface points of the parsed ellipsoids, called again after changing forceddensity to resample them without reading the file
+    void sample(pointpattern& pp)
+    {
+        if (steps == 1)
+        {
+            for (ellip const& e : ellipsoids)
+            {
+                pp.addpoint(e.l, e.cx, e.cy, e.cz);
+            }
+            return;
+        }
+
+        if (forceddensity.active()) density = forceddensity;
+
+        // the templates are kept for the next frame of a trajectory as long as the sampling does not change
+        std::vector<double> sampling = {shrink, double(steps), density.spacing, density.tolerance};
+        if (sampling != templatesampling)
+        {
+            templates = shapetemplatecache();
+            templatesampling = sampling;
+        }
         for (ellip e : ellipsoids)
         {
-            matrix rotate(e.x1, e.x2, e.x3, e.y1, e.y2, e.y3, e.z1, e.z2, e.z3);
+            // all ellipsoids with the same semi-axes share one surface triangulation
+            shapekey k;
+            k.add(e.a);
+            k.add(e.b);
+            k.add(e.c);
+            shapetemplate const* s = templates.find(k);
+            if (s == nullptr)
+            {
+                s = &templates.insert(k, createtemplate(e.a, e.b, e.c));
+            }
 
-            svec center (e.cx,e.cy,e.cz);
+            rigidtransform t;
+            t.setlabel(e.l);
+            t.setrotation(e.x1, e.y1, e.z1, e.x2, e.y2, e.z2, e.x3, e.y3, e.z3);
+            t.settranslation(e.cx, e.cy, e.cz);
+            t.apply(*s, pp);
+        }
+    };
+private:
+    shapetemplatecache templates;
+    std::vector<double> templatesampling;
+
+    // surface triangulation of an ellipsoid with semi-axes a, b, c in its body frame, shifted inwards by shrink along the surface normal
+    shapetemplate createtemplate(double a, double b, double c) const
+    {
+        shapetemplate st;
 
+        if (density.active())
+        {
+            for (vec3 p : adaptiveellipsoid(a, b, c, density))
+            {
+                vec3 n{p.x/(a*a), p.y/(b*b), p.z/(c*c)};
+                p = p - normalize(n) * shrink;
+                st.addpoint(p.x, p.y, p.z);
+            }
+            return st;
+        }
 
-            double phi = -M_PI;   //-180 - 180
-            double theta = 0; //0 - 180
+        double phi = -M_PI;   //-180 - 180
+        double theta = 0; //0 - 180
 
-            double x,y,z;
+        double x,y,z;
 
-            double d_theta = M_PI/(2.*static_cast<double>(steps));
-            unsigned int theta_steps = 2*steps;
+        double d_theta = M_PI/(2.*static_cast<double>(steps));
+        unsigned int theta_steps = 2*steps;
 
-            for(unsigned int i = 0; i < theta_steps; i++ )
+        for(unsigned int i = 0; i < theta_steps; i++ )
+        {
+            theta = static_cast<double>(i)*d_theta;
+            unsigned int phi_steps = 4*steps*fabs(sin(theta));
+            double d_phi = 2.*M_PI/(static_cast<double>(phi_steps));
+            for(unsigned int j = 0; j < phi_steps; j++)
             {
-                theta = static_cast<double>(i)*d_theta;
-                unsigned int phi_steps = 4*steps*fabs(sin(theta));
-                double d_phi = 2.*M_PI/(static_cast<double>(phi_steps));
-                for(unsigned int j = 0; j < phi_steps; j++)
-                {
-                    phi = j*d_phi;
-
-                    x = e.a * sin(theta) * cos(phi);
-                    y = e.b * sin(theta) * sin(phi);
-                    z = e.c * cos(theta);
-
-                    svec p(x,y,z);
-
-                    x = e.b * e.c * sin(theta) * cos(phi);
-                    y = e.a * e.c * sin(theta) * sin(phi);
-                    z = e.a * e.b * cos(theta);
-
-                    svec s(x,y,z);
-
-                    double norm = s.abs();
-                    
-                    //std::cout << shrink<< std::endl;
-                    s = ( s * (1.0/ norm) ) * shrink;
-                    //std::cout << "shift : " << s.x() << " " << s.y() << " " << s.z() << std::endl;
-                    //std::cout << "point : " << p.x() << " " << p.y() << " " << p.z() << std::endl;
-                    p =  p - s;
-                    //std::cout << "pointn: " << p.x() << " " << p.y() << " " << p.z() << std::endl;
-                    
-                    p = rotate * p;
-                    p = p + center;
-                     
-                    pp.addpoint(e.l, p.x(), p.y(), p.z());
-                }
+                phi = j*d_phi;
+
+                x = a * sin(theta) * cos(phi);
+                y = b * sin(theta) * sin(phi);
+                z = c * cos(theta);
+
+                vec3 p{x,y,z};
+
+                // surface normal
+                x = b * c * sin(theta) * cos(phi);
+                y = a * c * sin(theta) * sin(phi);
+                z = a * b * cos(theta);
+
+                vec3 n{x,y,z};
+
+                p = p - normalize(n) * shrink;
+                
+                st.addpoint(p.x, p.y, p.z);
             }
         }
-        std::cout << "parsed "  << linesloaded << " lines" << std::endl;
-
-        std::cout << "created N = " << pp.points.size() << " points"  << std::endl;
-        std::cout << "setting boundaries "<< std::endl;
-        //std::cout << "\t nx="<< nx << std::endl;
-        //std::cout << "\t nx="<< ny << std::endl;
-        //std::cout << "\t nx="<< nz << std::endl;
-        
-        xmin = 0;
-        ymin = 0;
-        zmin = 0;
+        return st;
     };
-private:
+
     static void dumbShrink (std::vector<point>& p, double f  = 0.95)
     {
         if(p.size() == 0) return;
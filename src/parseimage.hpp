@@ -0,0 +1,293 @@
+/* 
+Copyright 2016 Simon Weis and Philipp Schoenhoefer
+
+This file is part of Pomelo.
+
+Pomelo is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Pomelo is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Pomelo.  If not, see <http://www.gnu.org/licenses/>.
+
+The development of Pomelo took place at the Friedrich-Alexander University of Erlangen and was funded by the German Research Foundation (DFG) Forschergruppe FOR1548 "Geometry and Physics of Spatial Random Systems" (GPSRS). 
+*/
+#ifndef PARSEIMAGE_H_GUARD_123456
+#define PARSEIMAGE_H_GUARD_123456
+
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <limits>
+#include <cstdio>
+#include <cstdint>
+#include "pointpattern.hpp"
+#include "splitstring.hpp"
+
+// reads a labeled 3d image slice by slice, either from one raw volume or from one raw file per slice
+// voxels are stored x fastest, then y (and z for the volume), as little endian unsigned integers
+class imagestream
+{
+public:
+    std::string file;       // one raw volume
+    std::string slices;     // printf pattern of the slice files, e.g. slice_%04d.raw
+    int first;              // number of the first slice file
+    unsigned int nx, ny, nz;
+    unsigned int bytes;     // 1, 2 or 4 bytes per voxel
+
+    imagestream () : first(0), nx(0), ny(0), nz(0), bytes(1)
+    {};
+
+    void readslice(unsigned int z, std::vector<std::uint32_t>& slice)
+    {
+        size_t n = static_cast<size_t>(nx)*ny;
+        std::vector<unsigned char> buffer(n*bytes);
+        std::ifstream infile;
+        if (!file.empty())
+        {
+            infile.open(file, std::ios::binary);
+            infile.seekg(static_cast<std::streamoff>(z)*static_cast<std::streamoff>(buffer.size()));
+        }
+        else
+        {
+            std::vector<char> name(slices.size() + 32);
+            std::snprintf(name.data(), name.size(), slices.c_str(), first + static_cast<int>(z));
+            infile.open(name.data(), std::ios::binary);
+        }
+        infile.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+        if (!infile) throw std::string("cannot read slice " + std::to_string(z) + " of the image");
+
+        slice.resize(n);
+        for (size_t i = 0; i != n; ++i)
+        {
+            std::uint32_t v = 0;
+            for (unsigned int b = 0; b != bytes; ++b) v |= static_cast<std::uint32_t>(buffer[i*bytes + b]) << (8*b);
+            slice[i] = v;
+        }
+    };
+};
+
+
+// labeled 3d images (tomography), every label except the background is one particle
+// the input file only contains parameters, one or several comma separated key = value pairs per line:
+//   # nx = 400, ny = 400, nz = 600, datatype = uint16, voxelsize = 1
+//   # file = labels.raw          (or: slices = slice_%04d.raw, first = 0)
+//   # boundary_condition = periodic_cuboidal, subsample = 2, background = 0
+// a voxel is a surface point of its label if one of its six neighbors has another label (or is outside of a
+// non periodic image). Only three slices (four for periodic z) are kept in memory, the points go straight into the
+// pointpattern at the voxel centers. subsample = s keeps the surface voxel closest to the center of every s*s*s
+// block per label, which thins the surface points by about s*s
+class parseimage
+{
+public:
+    double xmin;
+    double ymin;
+    double zmin;
+    double xmax;
+    double ymax;
+    double zmax;
+    double voxelsize;
+    unsigned int subsample;
+    std::uint32_t background;
+    bool xpbc;
+    bool ypbc;
+    bool zpbc;
+
+    parseimage () : xmin(0),  ymin(0), zmin(0), xmax(0) ,ymax(0), zmax(0), voxelsize(1), subsample(1), background(0), xpbc(false), ypbc(false), zpbc(false)
+    {};
+
+    void parse(std::string const filename, pointpattern& pp)
+    {
+        std::cout << "parse image file" << std::endl;
+        std::ifstream infile;
+        infile.open(filename);
+        if (infile.fail())
+        {
+            throw std::string("cannot open image input file");
+        }
+        std::string folder = "";
+        if (filename.find_last_of('/') != std::string::npos) folder = filename.substr(0, filename.find_last_of('/') + 1);
+
+        imagestream image;
+        std::string line = "";
+        while(std::getline(infile, line))
+        {
+            if (line.find('#') != std::string::npos) line = line.substr(line.find('#') + 1);
+            splitstring commentline(line.c_str());
+            std::vector<std::string> parameters = commentline.split(',');
+            for (auto s:parameters)
+            {
+                if (s.find('=') == std::string::npos) continue;
+                splitstring split (s.c_str());
+                std::vector<std::string> valuesplit = split.split('=');
+                if (valuesplit.size() != 2)
+                    throw std::string("cannot parse parameters from image file");
+                std::string key = trim(valuesplit[0]);
+                std::string value = trim(valuesplit[1]);
+
+                if (key == "nx") image.nx = std::stoul(value);
+                else if (key == "ny") image.ny = std::stoul(value);
+                else if (key == "nz") image.nz = std::stoul(value);
+                else if (key == "voxelsize") voxelsize = std::stod(value);
+                else if (key == "subsample") subsample = std::stoul(value);
+                else if (key == "background") background = std::stoul(value);
+                else if (key == "first") image.first = std::stoi(value);
+                else if (key == "file") image.file = (value[0] == '/') ? value : folder + value;
+                else if (key == "slices") image.slices = (value[0] == '/') ? value : folder + value;
+                else if (key == "datatype")
+                {
+                    if (value == "uint8") image.bytes = 1;
+                    else if (value == "uint16") image.bytes = 2;
+                    else if (value == "uint32") image.bytes = 4;
+                    else throw std::string("unknown datatype " + value + " in image file, use uint8, uint16 or uint32");
+                }
+                else if (key == "boundary_condition")
+                {
+                    if (value.find("periodic_cuboidal") != std::string::npos) xpbc = ypbc = zpbc = true;
+                }
+                else throw std::string("unknown parameter " + key + " in image file");
+                std::cout << "image parser " << key << ": " << value << std::endl;
+            }
+        }
+        if (image.nx == 0 || image.ny == 0 || image.nz == 0) throw std::string("image file needs nx, ny and nz");
+        if (image.file.empty() == image.slices.empty()) throw std::string("image file needs either file or slices");
+        if (voxelsize <= 0) throw std::string("voxelsize has to be positive");
+        if (subsample == 0) throw std::string("subsample has to be at least 1");
+
+        xmin = ymin = zmin = 0;
+        xmax = image.nx*voxelsize;
+        ymax = image.ny*voxelsize;
+        zmax = image.nz*voxelsize;
+        extract(image, pp);
+
+        std::cout << "created N = " << pp.points.size() << " points"  << std::endl;
+        if (pp.points.empty()) throw std::string("no particles in image");
+    };
+
+private:
+    // best surface voxel of one label in one subsample block
+    struct candidate
+    {
+        unsigned int distance;
+        unsigned int x, y, z;
+    };
+
+    static std::string trim(std::string const& s)
+    {
+        size_t b = s.find_first_not_of(" \t\r");
+        if (b == std::string::npos) return "";
+        size_t e = s.find_last_not_of(" \t\r");
+        return s.substr(b, e - b + 1);
+    };
+
+    void extract(imagestream& image, pointpattern& pp)
+    {
+        unsigned int const nx = image.nx;
+        unsigned int const ny = image.ny;
+        unsigned int const nz = image.nz;
+        unsigned int const s = subsample;
+        unsigned int const nbx = (nx + s - 1)/s;
+
+        // slices z-1, z and z+1, empty if outside of the image. With periodic z, the first slice is kept for the last one
+        std::vector<std::uint32_t> below, current, above, firstslice;
+        image.readslice(0, current);
+        if (zpbc)
+        {
+            firstslice = current;
+            if (nz > 1) image.readslice(nz - 1, below);
+            else below = current;
+        }
+
+        std::map<std::pair<unsigned int, std::uint32_t>, candidate> blocks;
+        auto addpoint = [&](std::uint32_t l, unsigned int x, unsigned int y, unsigned int z)
+        {
+            if (l > static_cast<std::uint32_t>(std::numeric_limits<int>::max())) throw std::string("label " + std::to_string(l) + " is too large");
+            pp.addpoint(static_cast<int>(l), (x + 0.5)*voxelsize, (y + 0.5)*voxelsize, (z + 0.5)*voxelsize);
+        };
+
+        std::cout << "extracting surface voxels ";
+        unsigned int percent = 0;
+        for (unsigned int z = 0; z != nz; ++z)
+        {
+            if (z + 1 < nz) image.readslice(z + 1, above);
+            else if (zpbc) above = firstslice;
+            else above.clear();
+
+            for (unsigned int y = 0; y != ny; ++y)
+            {
+                for (unsigned int x = 0; x != nx; ++x)
+                {
+                    std::uint32_t l = current[static_cast<size_t>(y)*nx + x];
+                    if (l == background) continue;
+                    if (!isboundary(l, x, y, nx, ny, below, current, above)) continue;
+
+                    if (s == 1)
+                    {
+                        addpoint(l, x, y, z);
+                        continue;
+                    }
+                    // squared distance to the center of the block, in units of half voxels
+                    unsigned int dx = 2*(x%s) + 1;
+                    unsigned int dy = 2*(y%s) + 1;
+                    unsigned int dz = 2*(z%s) + 1;
+                    dx = std::max(dx, s) - std::min(dx, s);
+                    dy = std::max(dy, s) - std::min(dy, s);
+                    dz = std::max(dz, s) - std::min(dz, s);
+                    candidate c{dx*dx + dy*dy + dz*dz, x, y, z};
+                    auto key = std::make_pair((y/s)*nbx + x/s, l);
+                    auto it = blocks.find(key);
+                    if (it == blocks.end()) blocks.insert(std::make_pair(key, c));
+                    else if (c.distance < it->second.distance) it->second = c;
+                }
+            }
+
+            // a layer of blocks is finished
+            if ((z + 1)%s == 0 || z + 1 == nz)
+            {
+                for (auto const& b : blocks) addpoint(b.first.second, b.second.x, b.second.y, b.second.z);
+                blocks.clear();
+            }
+
+            below.swap(current);
+            current.swap(above);
+            while (percent < (100*(z + 1))/nz)
+            {
+                percent += 10;
+                std::cout << percent << " % " << std::flush;
+            }
+        }
+        std::cout << std::endl;
+    };
+
+    bool isboundary(std::uint32_t l, unsigned int x, unsigned int y, unsigned int nx, unsigned int ny,
+        std::vector<std::uint32_t> const& below, std::vector<std::uint32_t> const& current, std::vector<std::uint32_t> const& above) const
+    {
+        size_t const i = static_cast<size_t>(y)*nx + x;
+        if (below.empty() || below[i] != l) return true;
+        if (above.empty() || above[i] != l) return true;
+
+        size_t const outside = std::numeric_limits<size_t>::max();
+        size_t const row = static_cast<size_t>(y)*nx;
+        size_t const neighbors[4] = {
+            (x > 0) ? i - 1 : (xpbc ? row + nx - 1 : outside),
+            (x + 1 < nx) ? i + 1 : (xpbc ? row : outside),
+            (y > 0) ? i - nx : (ypbc ? static_cast<size_t>(ny - 1)*nx + x : outside),
+            (y + 1 < ny) ? i + nx : (ypbc ? x : outside)};
+        for (size_t j : neighbors)
+        {
+            if (j == outside || current[j] != l) return true;
+        }
+        return false;
+    };
+};
+
+#endif
@@ -0,0 +1,472 @@
+/* 
+Copyright 2016 Simon Weis and Philipp Schoenhoefer
+
+This file is part of Pomelo.
+
+Pomelo is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Pomelo is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Pomelo.  If not, see <http://www.gnu.org/licenses/>.
+
+The development of Pomelo took place at the Friedrich-Alexander University of Erlangen and was funded by the German Research Foundation (DFG) Forschergruppe FOR1548 "Geometry and Physics of Spatial Random Systems" (GPSRS). 
+*/
+#ifndef PARSEMESH_H_GUARD_123456
+#define PARSEMESH_H_GUARD_123456
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <vector>
+#include <map>
+#include <tuple>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <cstdint>
+#include "pointpattern.hpp"
+#include "splitstring.hpp"
+#include "shapetemplate.hpp"
+#include "adaptivesampling.hpp"
+#include "vec3.hpp"
+
+// closed triangle mesh of one grain in its body frame, vertices that are shared by several triangles are stored once
+struct surfacemesh
+{
+    std::vector<vec3> vertices;
+    std::vector<unsigned int> triangles;    // three vertex indices per triangle
+};
+
+// one grain: the mesh it is made of and its pose
+struct meshparticle
+{
+    std::string mesh;
+    int label;
+    double x, y, z;
+    double a11, a12, a13, a21, a22, a23, a31, a32, a33;
+};
+
+
+// grains given as triangle meshes (binary or ascii STL, OBJ) that are loaded once per mesh and instanced per particle
+// the file consists of # comment lines with the parameters, the mesh library and the particles:
+//   # boundary_condition = periodic_cuboidal, boxsz = 10, shrink = 0.01, spacing = 0.05
+//   mesh grain grain.stl
+//   grain 1 x y z a11 a12 a13 a21 a22 a23 a31 a32 a33
+// mesh paths are relative to the particle file. A body-frame vertex v of particle (label 1) is placed at R v + (x, y, z)
+// with the rotation matrix R given row by row, meshes in lab coordinates use the identity and no translation
+class parsemesh
+{
+public:
+    double xmin;
+    double ymin;
+    double zmin;
+    double xmax;
+    double ymax;
+    double zmax;
+    double shrink;      // distance by which the surface is moved inwards along the vertex normals
+    samplingdensity density;    // spacing of the surface points, the mean edge length of the mesh if not set
+    samplingdensity forceddensity;  // replaces the density of the input file if set, used for the levels of the convergence study
+    bool boxset;
+    std::map<std::string, surfacemesh> meshes; // loaded meshes by name
+    std::vector<meshparticle> particles;
+    bool xpbc;
+    bool ypbc;
+    bool zpbc;
+
+    parsemesh () : xmin(0),  ymin(0), zmin(0), xmax(0) ,ymax(0), zmax(0), shrink(0), boxset(false), xpbc(false), ypbc(false), zpbc(false)
+    {};
+
+    void parse(std::string const filename, pointpattern& pp)
+    {
+        std::cout << "parse mesh file" << std::endl;
+        std::ifstream infile;
+        infile.open(filename);
+        if (infile.fail())
+        {
+            throw std::string("cannot open mesh input file");
+        }
+        std::string folder = "";
+        if (filename.find_last_of('/') != std::string::npos) folder = filename.substr(0, filename.find_last_of('/') + 1);
+
+        std::string line = "";
+        std::map<std::string, std::string> meshfiles;
+
+        while(std::getline(infile, line))   // parse lines
+        {
+            if(line.find('#') != std::string::npos)
+            {
+                parseparameters(line);
+                continue;
+            }
+            std::istringstream iss(line);
+            std::string key;
+            if (!(iss >> key)) continue;
+
+            if (key == "mesh")
+            {
+                std::string name, path;
+                if (!(iss >> name >> path)) throw std::string("cannot parse mesh line in mesh file: " + line);
+                if (meshfiles.count(name) != 0) throw std::string("mesh " + name + " is defined twice");
+                meshfiles[name] = (path[0] == '/') ? path : folder + path;
+                continue;
+            }
+
+            meshparticle p;
+            p.mesh = key;
+            if (!(iss >> p.label >> p.x >> p.y >> p.z >> p.a11 >> p.a12 >> p.a13 >> p.a21 >> p.a22 >> p.a23 >> p.a31 >> p.a32 >> p.a33))
+            {
+                std::cerr << "error parsing one line in mesh file" << std::endl;
+                std::cout << line << std::endl;
+                break;
+            }
+            particles.push_back(p);
+        }
+        if ((xpbc || ypbc || zpbc) && !boxset)
+            throw std::string("periodic boundaries need the boxsz parameter in the mesh file");
+        if (shrink < 0) throw std::string("shrink has to be positive");
+
+        // every mesh is loaded once, on first use
+        for (meshparticle const& p : particles)
+        {
+            if (meshes.count(p.mesh) != 0) continue;
+            auto m = meshfiles.find(p.mesh);
+            if (m == meshfiles.end()) throw std::string("unknown mesh " + p.mesh + " in mesh file");
+            surfacemesh const& s = meshes[p.mesh] = load(m->second);
+            std::cout << "mesh " << p.mesh << ": " << s.vertices.size() << " vertices, " << s.triangles.size()/3 << " triangles" << std::endl;
+        }
+        sample(pp);
+
+        std::cout << "parsed "  << particles.size() << " particles of " << templates.size() << " meshes" << std::endl;
+        std::cout << "created N = " << pp.points.size() << " points"  << std::endl;
+        if (pp.points.empty()) throw std::string("no particles in mesh file");
+
+        if (!boxset)
+        {
+            std::cout << "setting boundaries "<< std::endl;
+            xmin = ymin = zmin = std::numeric_limits<double>::max();
+            xmax = ymax = zmax = std::numeric_limits<double>::lowest();
+            for (point const& p : pp.points)
+            {
+                xmin = std::min(xmin, p.x); xmax = std::max(xmax, p.x);
+                ymin = std::min(ymin, p.y); ymax = std::max(ymax, p.y);
+                zmin = std::min(zmin, p.z); zmax = std::max(zmax, p.z);
+            }
+        }
+    };
+
+    // surface points of the parsed particles, called again after changing forceddensity to resample them without reading the files
+    void sample(pointpattern& pp)
+    {
+        if (forceddensity.active()) density = forceddensity;
+
+        // every mesh is resampled once, on first use
+        templates.clear();
+        for (meshparticle const& p : particles)
+        {
+            auto it = templates.find(p.mesh);
+            if (it == templates.end())
+            {
+                it = templates.insert(std::make_pair(p.mesh, createtemplate(meshes[p.mesh]))).first;
+                std::cout << "mesh " << p.mesh << ": " << it->second.size() << " surface points" << std::endl;
+            }
+
+            rigidtransform t;
+            t.setlabel(p.label);
+            t.setorthonormalrotation(p.a11, p.a12, p.a13, p.a21, p.a22, p.a23, p.a31, p.a32, p.a33);
+            t.settranslation(p.x, p.y, p.z);
+            t.apply(it->second, pp);
+        }
+    };
+
+private:
+    std::map<std::string, shapetemplate> templates;
+
+    void parseparameters(std::string const& line)
+    {
+        splitstring commentline(line.substr(line.find('#') + 1).c_str());
+        std::vector<std::string> parameters = commentline.split(',');
+        for (auto s:parameters)
+        {
+            if (s.find('=') == std::string::npos) continue;
+            splitstring split (s.c_str());
+            std::vector<std::string> valuesplit = split.split('=');
+            if (valuesplit.size() != 2)
+                throw std::string("cannot parse parameters from mesh file");
+
+            if (s.find("boxsz") != std::string::npos)
+            {
+                double v = std::stod(valuesplit[1]);
+                std::cout << "mesh parser boxsize: " << v << std::endl;
+                xmin = ymin = zmin = 0;
+                xmax = ymax = zmax = v;
+                boxset = true;
+            }
+            else if (s.find("boundary_condition") != std::string::npos)
+            {
+                if (valuesplit[1].find("periodic_cuboidal") != std::string::npos)
+                {
+                    xpbc = ypbc = zpbc = true;
+                    std::cout << "mesh parser boundaries: " << valuesplit[1] << std::endl;
+                }
+            }
+            else if (s.find("shrink") != std::string::npos)
+            {
+                shrink = std::stod(valuesplit[1]);
+                std::cout << "loaded a shrink value of " << shrink << std::endl;
+            }
+            else if (s.find("spacing") != std::string::npos)
+            {
+                density.spacing = std::stod(valuesplit[1]);
+                std::cout << "spacing: " << density.spacing << std::endl;
+            }
+        }
+    };
+
+    // the format is taken from the file ending (.stl or .obj), binary and ascii STL are told apart by the file size
+    static surfacemesh load(std::string const& filename)
+    {
+        std::string ending = filename.substr(filename.find_last_of('.') + 1);
+        std::transform(ending.begin(), ending.end(), ending.begin(), ::tolower);
+        surfacemesh m;
+        if (ending == "stl") m = loadstl(filename);
+        else if (ending == "obj") m = loadobj(filename);
+        else throw std::string("unknown mesh format of " + filename + ", use .stl or .obj");
+        if (m.triangles.size() < 12) throw std::string("mesh " + filename + " has less than 4 triangles");
+        return m;
+    };
+
+    // STL stores every triangle with its own copy of the vertices, identical coordinates are merged into one vertex
+    class vertexwelder
+    {
+    public:
+        surfacemesh& m;
+        std::map<std::tuple<double, double, double>, unsigned int> ids;
+
+        vertexwelder (surfacemesh& cm) : m(cm)
+        {};
+
+        void add(double x, double y, double z)
+        {
+            auto key = std::make_tuple(x, y, z);
+            auto it = ids.find(key);
+            if (it == ids.end())
+            {
+                it = ids.insert(std::make_pair(key, static_cast<unsigned int>(m.vertices.size()))).first;
+                m.vertices.push_back(vec3{x, y, z});
+            }
+            m.triangles.push_back(it->second);
+        };
+    };
+
+    // binary STL: 80 byte header, uint32 number of triangles, then per triangle the normal and three vertices
+    // as 12 little endian floats and a uint16 attribute. The normals of the file are not used
+    static surfacemesh loadstl(std::string const& filename)
+    {
+        std::ifstream infile(filename, std::ios::binary | std::ios::ate);
+        if (infile.fail()) throw std::string("cannot open mesh " + filename);
+        std::streamoff size = infile.tellg();
+        infile.seekg(0);
+
+        surfacemesh m;
+        vertexwelder w(m);
+        char header[80];
+        std::uint32_t n = 0;
+        infile.read(header, 80);
+        infile.read(reinterpret_cast<char*>(&n), 4);
+        if (infile && size == 84 + 50*static_cast<std::streamoff>(n))
+        {
+            for (std::uint32_t i = 0; i != n; ++i)
+            {
+                float f[12];
+                char attribute[2];
+                infile.read(reinterpret_cast<char*>(f), 48);
+                infile.read(attribute, 2);
+                for (unsigned int j = 1; j != 4; ++j) w.add(f[3*j], f[3*j + 1], f[3*j + 2]);
+            }
+            if (!infile) throw std::string("cannot read binary STL " + filename);
+            return m;
+        }
+
+        // ascii STL: only the "vertex x y z" lines matter
+        infile.clear();
+        infile.seekg(0);
+        std::string line;
+        while (std::getline(infile, line))
+        {
+            std::istringstream iss(line);
+            std::string key;
+            double x, y, z;
+            if (!(iss >> key) || key != "vertex") continue;
+            if (!(iss >> x >> y >> z)) throw std::string("cannot parse vertex line in " + filename + ": " + line);
+            w.add(x, y, z);
+        }
+        if (m.triangles.size() % 3 != 0) throw std::string("incomplete triangle in " + filename);
+        return m;
+    };
+
+    // OBJ: "v x y z" and "f i j k ..." with 1-based (or negative, relative) indices, polygons are triangulated as fans
+    static surfacemesh loadobj(std::string const& filename)
+    {
+        std::ifstream infile(filename);
+        if (infile.fail()) throw std::string("cannot open mesh " + filename);
+        surfacemesh m;
+        std::string line;
+        while (std::getline(infile, line))
+        {
+            std::istringstream iss(line);
+            std::string key;
+            if (!(iss >> key)) continue;
+            if (key == "v")
+            {
+                vec3 v;
+                if (!(iss >> v.x >> v.y >> v.z)) throw std::string("cannot parse vertex line in " + filename + ": " + line);
+                m.vertices.push_back(v);
+            }
+            else if (key == "f")
+            {
+                // "i", "i/t" or "i/t/n", only the vertex index is used
+                std::vector<unsigned int> f;
+                std::string token;
+                while (iss >> token)
+                {
+                    long i = std::stol(token.substr(0, token.find('/')));
+                    if (i < 0) i += static_cast<long>(m.vertices.size()) + 1;
+                    if (i < 1 || i > static_cast<long>(m.vertices.size())) throw std::string("face refers to a vertex that does not exist in " + filename);
+                    f.push_back(static_cast<unsigned int>(i - 1));
+                }
+                if (f.size() < 3) throw std::string("cannot parse face line in " + filename + ": " + line);
+                for (size_t i = 1; i + 1 < f.size(); ++i)
+                {
+                    m.triangles.push_back(f[0]);
+                    m.triangles.push_back(f[i]);
+                    m.triangles.push_back(f[i+1]);
+                }
+            }
+        }
+        return m;
+    };
+
+    // surface points of one mesh: the vertices, points on every edge and a barycentric grid inside every triangle,
+    // so that no two neighboring points are further apart than the spacing. Every point is moved inwards by shrink
+    // along the normal interpolated from the vertex normals
+    shapetemplate createtemplate(surfacemesh& m) const
+    {
+        std::vector<vec3>& v = m.vertices;
+        std::vector<unsigned int>& t = m.triangles;
+
+        // the triangles have to be oriented consistently, outwards if the enclosed volume is positive
+        double volume = 0;
+        for (size_t i = 0; i < t.size(); i += 3) volume += dot(v[t[i]], cross(v[t[i+1]], v[t[i+2]]))/6.0;
+        if (volume == 0) throw std::string("mesh does not enclose a volume");
+        if (volume < 0)
+        {
+            for (size_t i = 0; i < t.size(); i += 3) std::swap(t[i+1], t[i+2]);
+        }
+
+        // angle weighted vertex normals
+        std::vector<vec3> normals(v.size(), vec3{0, 0, 0});
+        std::vector<double> longest(v.size(), 0);   // longest edge at every vertex
+        double edgelength = 0;
+        for (size_t i = 0; i < t.size(); i += 3)
+        {
+            vec3 n = cross(v[t[i+1]] - v[t[i]], v[t[i+2]] - v[t[i]]);
+            if (n.length() == 0) continue;
+            n = normalize(n);
+            for (unsigned int j = 0; j != 3; ++j)
+            {
+                vec3 a = v[t[i + (j+1)%3]] - v[t[i+j]];
+                vec3 b = v[t[i + (j+2)%3]] - v[t[i+j]];
+                double angle = std::atan2(cross(a, b).length(), dot(a, b));
+                normals[t[i+j]] = normals[t[i+j]] + n*angle;
+                edgelength += a.length();
+                longest[t[i+j]] = std::max(longest[t[i+j]], a.length());
+                longest[t[i + (j+1)%3]] = std::max(longest[t[i + (j+1)%3]], a.length());
+            }
+        }
+        double h = (density.spacing > 0) ? density.spacing : edgelength/static_cast<double>(t.size());
+
+        shapetemplate st;
+        auto add = [&](vec3 const& p, vec3 const& n)
+        {
+            vec3 q = (n.length() > 0) ? p - normalize(n)*shrink : p;
+            st.addpoint(q.x, q.y, q.z);
+        };
+        // vertices that are not part of a triangle (possible in OBJ files) have no normal and are skipped.
+        // Where all edges of a vertex are shorter than the spacing, the mesh is finer than needed (e.g. scanned
+        // grains), so these vertices are thinned to the spacing as in the adaptive sampling. The vertices of longer
+        // edges are always kept, their edges are filled with points below
+        std::vector<vec3> candidates;
+        std::vector<double> spacing;
+        std::vector<size_t> vertex;
+        bool thin = false;
+        for (size_t i = 0; i != v.size(); ++i)
+        {
+            if (normals[i].length() == 0) continue;
+            candidates.push_back(v[i]);
+            spacing.push_back(longest[i] < h ? h : 0);
+            vertex.push_back(i);
+            if (longest[i] < h) thin = true;
+        }
+        if (thin)
+        {
+            for (unsigned int k : thinbyspacing(candidates, spacing)) add(v[vertex[k]], normals[vertex[k]]);
+        }
+        else
+        {
+            for (size_t i : vertex) add(v[i], normals[i]);
+        }
+
+        // points on the edges, every edge is sampled once even if it is shared by two triangles
+        std::map<std::pair<unsigned int, unsigned int>, unsigned int> edges;
+        for (size_t i = 0; i < t.size(); i += 3)
+        {
+            for (unsigned int j = 0; j != 3; ++j)
+            {
+                unsigned int a = t[i+j];
+                unsigned int b = t[i + (j+1)%3];
+                if (a > b) std::swap(a, b);
+                if (edges.count(std::make_pair(a, b)) != 0) continue;
+                unsigned int n = static_cast<unsigned int>(std::ceil((v[b] - v[a]).length()/h));
+                edges[std::make_pair(a, b)] = n;
+                for (unsigned int k = 1; k < n; ++k)
+                {
+                    double s = static_cast<double>(k)/n;
+                    add(v[a]*(1 - s) + v[b]*s, normals[a]*(1 - s) + normals[b]*s);
+                }
+            }
+        }
+
+        // points inside the triangles, on a grid as fine as needed for the longest edge
+        for (size_t i = 0; i < t.size(); i += 3)
+        {
+            unsigned int n = 0;
+            for (unsigned int j = 0; j != 3; ++j)
+            {
+                unsigned int a = t[i+j];
+                unsigned int b = t[i + (j+1)%3];
+                n = std::max(n, edges[std::make_pair(std::min(a, b), std::max(a, b))]);
+            }
+            for (unsigned int j = 1; j < n; ++j)
+            {
+                for (unsigned int k = 1; j + k < n; ++k)
+                {
+                    double u = static_cast<double>(j)/n;
+                    double w = static_cast<double>(k)/n;
+                    double s = 1 - u - w;
+                    add(v[t[i]]*s + v[t[i+1]]*u + v[t[i+2]]*w, normals[t[i]]*s + normals[t[i+1]]*u + normals[t[i+2]]*w);
+                }
+            }
+        }
+        return st;
+    };
+};
+
+#endif
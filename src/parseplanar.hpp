@@ -0,0 +1,299 @@
+/* 
+Copyright 2016 Simon Weis and Philipp Schoenhoefer
+
+This file is part of Pomelo.
+
+Pomelo is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Pomelo is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Pomelo.  If not, see <http://www.gnu.org/licenses/>.
+
+The development of Pomelo took place at the Friedrich-Alexander University of Erlangen and was funded by the German Research Foundation (DFG) Forschergruppe FOR1548 "Geometry and Physics of Spatial Random Systems" (GPSRS). 
+*/
+#ifndef PARSEPLANAR_H_GUARD_123456
+#define PARSEPLANAR_H_GUARD_123456
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include "pointpattern.hpp"
+#include "splitstring.hpp"
+
+// particles in the plane, given by their outlines. One shape per line, shapes with the same label form one particle:
+//   # boundary_condition = periodic_cuboidal, boxsz = 10, spacing = 0.05, shrink = 0.01
+//   circle label x y r
+//   ellipse label x y a b ux uy        (semi-axis a along the direction (ux, uy), b perpendicular to it)
+//   polygon label x1 y1 x2 y2 x3 y3 ...
+// the outlines are sampled with the given spacing (a fifth of the radius, the smaller semi-axis or the mean edge
+// length by default) and moved inwards by shrink. All points have z = 0
+class parseplanar
+{
+public:
+    double xmin;
+    double ymin;
+    double zmin;
+    double xmax;
+    double ymax;
+    double zmax;
+    double shrink;      // distance by which the outlines are moved inwards
+    double spacing;     // distance of the points along the outlines
+    bool boxset;
+    bool xpbc;
+    bool ypbc;
+    bool zpbc;
+
+    parseplanar () : xmin(0),  ymin(0), zmin(0), xmax(0) ,ymax(0), zmax(0), shrink(0), spacing(0), boxset(false), xpbc(false), ypbc(false), zpbc(false)
+    {};
+
+    void parse(std::string const filename, pointpattern& pp)
+    {
+        std::cout << "parse 2d file" << std::endl;
+        std::ifstream infile;
+        infile.open(filename);
+        if (infile.fail())
+        {
+            throw std::string("cannot open 2d input file");
+        }
+        std::string line = "";
+        std::vector<std::string> shapes;
+        while(std::getline(infile, line))   // parse lines
+        {
+            if(line.find('#') != std::string::npos)
+            {
+                parseparameters(line);
+                continue;
+            }
+            if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+            shapes.push_back(line);
+        }
+        if ((xpbc || ypbc) && !boxset)
+            throw std::string("periodic boundaries need the boxsz parameter in the 2d file");
+        if (shrink < 0) throw std::string("shrink has to be positive");
+
+        unsigned long linesloaded = 0;
+        for (std::string const& s : shapes)
+        {
+            std::istringstream iss(s);
+            std::string key;
+            int label;
+            iss >> key;
+            if (!(iss >> label))
+            {
+                std::cerr << "error parsing one line in 2d file" << std::endl;
+                std::cout << s << std::endl;
+                break;
+            }
+            if (key == "circle")
+            {
+                double x, y, r;
+                if (!(iss >> x >> y >> r)) throw std::string("cannot parse circle in 2d file: " + s);
+                circle(label, x, y, r, pp);
+            }
+            else if (key == "ellipse")
+            {
+                double x, y, a, b, ux, uy;
+                if (!(iss >> x >> y >> a >> b >> ux >> uy)) throw std::string("cannot parse ellipse in 2d file: " + s);
+                ellipse(label, x, y, a, b, ux, uy, pp);
+            }
+            else if (key == "polygon")
+            {
+                std::vector<double> v;
+                double c;
+                while (iss >> c) v.push_back(c);
+                if (v.size() < 6 || v.size()%2 != 0) throw std::string("cannot parse polygon in 2d file: " + s);
+                polygon(label, v, pp);
+            }
+            else throw std::string("unknown shape " + key + " in 2d file");
+            linesloaded++;
+        }
+
+        std::cout << "parsed "  << linesloaded << " shapes" << std::endl;
+        std::cout << "created N = " << pp.points.size() << " points"  << std::endl;
+        if (pp.points.empty()) throw std::string("no particles in 2d file");
+
+        if (!boxset)
+        {
+            std::cout << "setting boundaries "<< std::endl;
+            xmin = ymin = std::numeric_limits<double>::max();
+            xmax = ymax = std::numeric_limits<double>::lowest();
+            for (point const& p : pp.points)
+            {
+                xmin = std::min(xmin, p.x); xmax = std::max(xmax, p.x);
+                ymin = std::min(ymin, p.y); ymax = std::max(ymax, p.y);
+            }
+        }
+    };
+
+private:
+    void parseparameters(std::string const& line)
+    {
+        splitstring commentline(line.substr(line.find('#') + 1).c_str());
+        std::vector<std::string> parameters = commentline.split(',');
+        for (auto s:parameters)
+        {
+            if (s.find('=') == std::string::npos) continue;
+            splitstring split (s.c_str());
+            std::vector<std::string> valuesplit = split.split('=');
+            if (valuesplit.size() != 2)
+                throw std::string("cannot parse parameters from 2d file");
+
+            if (s.find("boxsz") != std::string::npos)
+            {
+                double v = std::stod(valuesplit[1]);
+                std::cout << "2d parser boxsize: " << v << std::endl;
+                xmin = ymin = 0;
+                xmax = ymax = v;
+                boxset = true;
+            }
+            else if (s.find("boundary_condition") != std::string::npos)
+            {
+                if (valuesplit[1].find("periodic_cuboidal") != std::string::npos)
+                {
+                    xpbc = ypbc = true;
+                    std::cout << "2d parser boundaries: " << valuesplit[1] << std::endl;
+                }
+            }
+            else if (s.find("shrink") != std::string::npos)
+            {
+                shrink = std::stod(valuesplit[1]);
+                std::cout << "loaded a shrink value of " << shrink << std::endl;
+            }
+            else if (s.find("spacing") != std::string::npos)
+            {
+                spacing = std::stod(valuesplit[1]);
+                std::cout << "spacing: " << spacing << std::endl;
+            }
+        }
+    };
+
+    // number of points on an outline of this length
+    unsigned int points(double length, double fallback) const
+    {
+        double h = (spacing > 0) ? spacing : fallback;
+        return std::max(3u, static_cast<unsigned int>(std::ceil(length/h)));
+    };
+
+    void circle(int label, double x, double y, double r, pointpattern& pp) const
+    {
+        double rs = r - shrink;
+        if (rs <= 0) throw std::string("shrink is larger than the radius of a circle");
+        unsigned int n = points(2*M_PI*rs, 0.2*rs);
+        for (unsigned int i = 0; i != n; ++i)
+        {
+            double t = 2*M_PI*i/n;
+            pp.addpoint(label, x + rs*std::cos(t), y + rs*std::sin(t), 0);
+        }
+    };
+
+    // the points are equally spaced in arc length and moved inwards along the normal, so the outline is the
+    // parallel curve of the ellipse
+    void ellipse(int label, double x, double y, double a, double b, double ux, double uy, pointpattern& pp) const
+    {
+        if (a <= 0 || b <= 0) throw std::string("semi-axes of an ellipse have to be positive");
+        if (shrink >= std::min(a, b)) throw std::string("shrink is larger than a semi-axis of an ellipse");
+        double u = std::hypot(ux, uy);
+        if (u == 0) throw std::string("ellipse without a direction");
+        ux /= u;
+        uy /= u;
+
+        // cumulative arc length on a fine parameter grid
+        double h = 3*(a + b) - std::sqrt((3*a + b)*(a + 3*b));    // ramanujan's perimeter
+        unsigned int n = points(M_PI*h, 0.2*std::min(a, b));
+        unsigned int fine = 16*n;
+        std::vector<double> arc(fine + 1, 0);
+        for (unsigned int i = 0; i != fine; ++i)
+        {
+            double t0 = 2*M_PI*i/fine;
+            double t1 = 2*M_PI*(i + 1)/fine;
+            arc[i + 1] = arc[i] + std::hypot(a*(std::cos(t1) - std::cos(t0)), b*(std::sin(t1) - std::sin(t0)));
+        }
+
+        unsigned int k = 0;
+        for (unsigned int i = 0; i != n; ++i)
+        {
+            double s = arc[fine]*i/n;
+            while (arc[k + 1] < s) ++k;
+            double t = 2*M_PI*(k + (s - arc[k])/(arc[k + 1] - arc[k]))/fine;
+            double px = a*std::cos(t);
+            double py = b*std::sin(t);
+            double nx = b*std::cos(t);
+            double ny = a*std::sin(t);
+            double nl = std::hypot(nx, ny);
+            px -= shrink*nx/nl;
+            py -= shrink*ny/nl;
+            pp.addpoint(label, x + ux*px - uy*py, y + uy*px + ux*py, 0);
+        }
+    };
+
+    // the edges are moved inwards by shrink (the vertices along the miter), then every edge is sampled separately
+    void polygon(int label, std::vector<double> v, pointpattern& pp) const
+    {
+        size_t const m = v.size()/2;
+        double signedarea = 0;
+        double perimeter = 0;
+        for (size_t k = 0; k != m; ++k)
+        {
+            size_t k1 = (k + 1)%m;
+            signedarea += v[2*k]*v[2*k1 + 1] - v[2*k1]*v[2*k + 1];
+            perimeter += std::hypot(v[2*k1] - v[2*k], v[2*k1 + 1] - v[2*k + 1]);
+        }
+        if (signedarea == 0) throw std::string("polygon in 2d file has no area");
+        double const orientation = (signedarea > 0) ? 1 : -1;
+
+        // outward normals of the edges
+        std::vector<double> normal(2*m);
+        for (size_t k = 0; k != m; ++k)
+        {
+            size_t k1 = (k + 1)%m;
+            double dx = v[2*k1] - v[2*k];
+            double dy = v[2*k1 + 1] - v[2*k + 1];
+            double length = std::hypot(dx, dy);
+            if (length == 0) throw std::string("polygon in 2d file has two equal vertices");
+            normal[2*k] = orientation*dy/length;
+            normal[2*k + 1] = -orientation*dx/length;
+        }
+        if (shrink > 0)
+        {
+            std::vector<double> w(v.size());
+            for (size_t k = 0; k != m; ++k)
+            {
+                size_t kp = (k + m - 1)%m;
+                double c = 1 + normal[2*kp]*normal[2*k] + normal[2*kp + 1]*normal[2*k + 1];
+                if (c < 1e-6) throw std::string("polygon in 2d file has a spike");
+                w[2*k] = v[2*k] - shrink*(normal[2*kp] + normal[2*k])/c;
+                w[2*k + 1] = v[2*k + 1] - shrink*(normal[2*kp + 1] + normal[2*k + 1])/c;
+            }
+            v.swap(w);
+        }
+
+        double fallback = 0.2*perimeter/m;
+        for (size_t k = 0; k != m; ++k)
+        {
+            size_t k1 = (k + 1)%m;
+            double dx = v[2*k1] - v[2*k];
+            double dy = v[2*k1 + 1] - v[2*k + 1];
+            double h = (spacing > 0) ? spacing : fallback;
+            unsigned int n = std::max(1u, static_cast<unsigned int>(std::ceil(std::hypot(dx, dy)/h)));
+            for (unsigned int i = 0; i != n; ++i)
+            {
+                double t = static_cast<double>(i)/n;
+                pp.addpoint(label, v[2*k] + t*dx, v[2*k + 1] + t*dy, 0);
+            }
+        }
+    };
+};
+
+#endif
@@ -0,0 +1,351 @@
+/* 
+Copyright 2016 Simon Weis and Philipp Schoenhoefer
+
+This file is part of Pomelo.
+
+Pomelo is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Pomelo is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Pomelo.  If not, see <http://www.gnu.org/licenses/>.
+
+The development of Pomelo took place at the Friedrich-Alexander University of Erlangen and was funded by the German Research Foundation (DFG) Forschergruppe FOR1548 "Geometry and Physics of Spatial Random Systems" (GPSRS). 
+*/
+#ifndef PARSEPOLYHEDRA_H_GUARD_123456
+#define PARSEPOLYHEDRA_H_GUARD_123456
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <limits>
+#include "pointpattern.hpp"
+#include "splitstring.hpp"
+#include "shapetemplate.hpp"
+#include "triangle.hpp"
+#include "vec3.hpp"
+
+// one convex polyhedron in its body frame, faces are lists of vertex indices
+struct polyhedronshape
+{
+    std::vector<vec3> vertices;
+    std::vector<std::vector<unsigned int> > faces;
+};
+
+
+// convex polyhedra that are defined once per shape and instanced per particle
+// the file consists of # comment lines with the parameters, the shape definitions and the particles:
+//   # boundary_condition = periodic_cuboidal, boxsz = 10, shrink = 0.95, depth = 3, blunt = 0.05
+//   shape cube
+//   v -0.5 -0.5 -0.5
+//   f 0 1 3 2
+//   cube 1 x y z a11 a12 a13 a21 a22 a23 a31 a32 a33
+// a body-frame vertex v of particle (label 1) is placed at R v + (x, y, z) with the rotation matrix R given row by row
+class parsepolyhedron
+{
+public:
+    double xmin;
+    double ymin;
+    double zmin;
+    double xmax;
+    double ymax;
+    double zmax;
+    double shrink;      // scale factor of the surface around the centroid of the shape
+    double blunt;       // radius of curvature of the rounded edges and vertices, 0 keeps them sharp
+    int depth;          // subdivisions of the triangulated faces
+    bool boxset;
+    std::map<std::string, polyhedronshape> shapes;
+    std::vector<std::pair<std::string, rigidtransform> > particles;   // shape name and pose
+    bool xpbc;
+    bool ypbc;
+    bool zpbc;
+    bool verbose;
+
+    parsepolyhedron () : xmin(0),  ymin(0), zmin(0), xmax(0) ,ymax(0), zmax(0), shrink(1), blunt(0), depth(3), boxset(false), xpbc(false), ypbc(false), zpbc(false), verbose(true)
+    {};
+
+    // the file parameters are read first, so that values from the command line can be set afterwards
+    void readparameters(std::string const filename)
+    {
+        std::ifstream infile;
+        infile.open(filename);
+        if (infile.fail())
+        {
+            throw std::string("cannot open polyhedron input file");
+        }
+        readparameters(infile);
+    };
+
+    void readparameters(std::istream& infile)
+    {
+        std::string line = "";
+        while(std::getline(infile, line))
+        {
+            if(line.find('#') == std::string::npos) continue;
+            splitstring commentline(line.substr(line.find('#') + 1).c_str());
+            std::vector<std::string> parameters = commentline.split(',');
+            for (auto s:parameters)
+            {
+                if (s.find('=') == std::string::npos) continue;
+                splitstring split (s.c_str());
+                std::vector<std::string> valuesplit = split.split('=');
+                if (valuesplit.size() != 2)
+                    throw std::string("cannot parse parameters from polyhedron file");
+
+                if (s.find("boxsz") != std::string::npos)
+                {
+                    double v = std::stod(valuesplit[1]);
+                    if (verbose) std::cout << "polyhedron parser boxsize: " << v << std::endl;
+                    xmin = ymin = zmin = 0;
+                    xmax = ymax = zmax = v;
+                    boxset = true;
+                }
+                else if (s.find("boundary_condition") != std::string::npos)
+                {
+                    if (valuesplit[1].find("periodic_cuboidal") != std::string::npos)
+                    {
+                        xpbc = ypbc = zpbc = true;
+                        if (verbose) std::cout << "polyhedron parser boundaries: " << valuesplit[1] << std::endl;
+                    }
+                }
+                else if (s.find("shrink") != std::string::npos)
+                {
+                    shrink = std::stod(valuesplit[1]);
+                    if (verbose) std::cout << "loaded a shrink value of " << shrink << std::endl;
+                }
+                else if (s.find("blunt") != std::string::npos)
+                {
+                    blunt = std::stod(valuesplit[1]);
+                    if (verbose) std::cout << "blunt: " << blunt << std::endl;
+                }
+                else if (s.find("depth") != std::string::npos)
+                {
+                    depth = std::stoi(valuesplit[1]);
+                    if (verbose) std::cout << "depth: " << depth << std::endl;
+                }
+            }
+        }
+        if ((xpbc || ypbc || zpbc) && !boxset)
+            throw std::string("periodic boundaries need the boxsz parameter in the polyhedron file");
+    };
+
+    void parse(std::string const filename, pointpattern& pp)
+    {
+        if (verbose) std::cout << "parse polyhedron file" << std::endl;
+        std::ifstream infile;
+        infile.open(filename);
+        if (infile.fail())
+        {
+            throw std::string("cannot open polyhedron input file");
+        }
+        parse(infile, pp);
+    };
+
+    // the whole stream is one frame (used for trajectories), the shapes and particles of the last call are replaced
+    void parse(std::istream& infile, pointpattern& pp)
+    {
+        shapes.clear();
+        particles.clear();
+        if (blunt < 0) throw std::string("blunt has to be positive");
+        if (depth < 0) throw std::string("depth has to be positive");
+        if (verbose) std::cout << "parse: using shrink of " << shrink << ", depth of " << depth << " and blunt of " << blunt << std::endl;
+
+        std::string line = "";
+        unsigned long linesloaded = 0;
+        polyhedronshape* current = nullptr;
+
+        while(std::getline(infile, line))   // parse lines
+        {
+            if(line.find('#') != std::string::npos) continue;
+            std::istringstream iss(line);
+            std::string key;
+            if (!(iss >> key)) continue;
+
+            if (key == "shape")
+            {
+                std::string name;
+                if (!(iss >> name)) throw std::string("shape without a name in polyhedron file");
+                if (shapes.count(name) != 0) throw std::string("shape " + name + " is defined twice");
+                current = &shapes[name];
+                continue;
+            }
+            if (key == "v")
+            {
+                vec3 v;
+                if (current == nullptr || !(iss >> v.x >> v.y >> v.z)) throw std::string("cannot parse vertex line in polyhedron file: " + line);
+                current->vertices.push_back(v);
+                continue;
+            }
+            if (key == "f")
+            {
+                std::vector<unsigned int> f;
+                unsigned int i;
+                while (iss >> i) f.push_back(i);
+                if (current == nullptr || f.size() < 3) throw std::string("cannot parse face line in polyhedron file: " + line);
+                current->faces.push_back(f);
+                continue;
+            }
+
+            // particle line
+            current = nullptr;
+            if (shapes.count(key) == 0) throw std::string("unknown shape " + key + " in polyhedron file");
+
+            int label;
+            double x, y, z;
+            double a11, a12, a13, a21, a22, a23, a31, a32, a33;
+            if (!(iss >> label >> x >> y >> z >> a11 >> a12 >> a13 >> a21 >> a22 >> a23 >> a31 >> a32 >> a33))
+            {
+                std::cerr << "error parsing one line in polyhedron file" << std::endl;
+                std::cout << line << std::endl;
+                break;
+            }
+            linesloaded++;
+
+            rigidtransform t;
+            t.setlabel(label);
+            t.setorthonormalrotation(a11, a12, a13, a21, a22, a23, a31, a32, a33);
+            t.settranslation(x, y, z);
+            particles.push_back(std::make_pair(key, t));
+        }
+        sample(pp);
+
+        if (verbose) std::cout << "parsed "  << linesloaded << " particles of " << templates.size() << " shapes" << std::endl;
+        if (verbose) std::cout << "created N = " << pp.points.size() << " points"  << std::endl;
+        if (pp.points.empty()) throw std::string("no particles in polyhedron file");
+
+        if (!boxset)
+        {
+            if (verbose) std::cout << "setting boundaries "<< std::endl;
+            xmin = ymin = zmin = std::numeric_limits<double>::max();
+            xmax = ymax = zmax = std::numeric_limits<double>::lowest();
+            for (point const& p : pp.points)
+            {
+                xmin = std::min(xmin, p.x); xmax = std::max(xmax, p.x);
+                ymin = std::min(ymin, p.y); ymax = std::max(ymax, p.y);
+                zmin = std::min(zmin, p.z); zmax = std::max(zmax, p.z);
+            }
+        }
+    };
+
+    // surface points of the parsed particles, called again after changing depth to resample them without reading the file
+    void sample(pointpattern& pp)
+    {
+        // the shape template is created on first use
+        templates.clear();
+        for (auto const& p : particles)
+        {
+            auto it = templates.find(p.first);
+            if (it == templates.end())
+            {
+                it = templates.insert(std::make_pair(p.first, createtemplate(shapes[p.first]))).first;
+                if (verbose) std::cout << "shape " << p.first << ": " << it->second.size() << " surface points" << std::endl;
+            }
+            p.second.apply(it->second, pp);
+        }
+    };
+
+private:
+    std::map<std::string, shapetemplate> templates;
+
+    // surface triangulation of one shape: the faces are triangulated as fans and subdivided depth times,
+    // then the edges are rounded and the surface is scaled around the centroid
+    shapetemplate createtemplate(polyhedronshape const& s) const
+    {
+        if (s.vertices.size() < 4 || s.faces.size() < 4) throw std::string("a polyhedron needs at least 4 vertices and 4 faces");
+
+        vec3 centroid{0, 0, 0};
+        for (vec3 const& v : s.vertices) centroid = centroid + v;
+        centroid = centroid * (1.0/static_cast<double>(s.vertices.size()));
+
+        trianglemesh mesh;
+        mesh.vertices = s.vertices;
+        std::vector<vec3> normals;
+        std::vector<double> offsets;
+        for (auto const& f : s.faces)
+        {
+            for (unsigned int i : f)
+            {
+                if (i >= s.vertices.size()) throw std::string("face refers to a vertex that does not exist");
+            }
+            for (size_t i = 1; i + 1 < f.size(); ++i)
+            {
+                mesh.addtriangle(f[0], f[i], f[i+1]);
+            }
+
+            // outward normal by newell's method, the orientation of the face in the file does not matter
+            vec3 n{0, 0, 0};
+            for (size_t i = 0; i != f.size(); ++i)
+            {
+                vec3 const& a = s.vertices[f[i]];
+                vec3 const& b = s.vertices[f[(i+1)%f.size()]];
+                n = n + cross(a, b);
+            }
+            if (n.length() == 0) throw std::string("degenerate face in polyhedron file");
+            n = normalize(n);
+            if (dot(n, s.vertices[f[0]] - centroid) < 0) n = -n;
+            normals.push_back(n);
+            offsets.push_back(dot(n, s.vertices[f[0]]));
+        }
+        mesh.subdivide(depth);
+
+        if (blunt > 0)
+        {
+            // the rounded polyhedron is the inner polyhedron (all faces moved inwards by blunt) dilated by a sphere
+            // of radius blunt. Points near edges and vertices are moved onto the sphere around their closest point
+            // on the inner polyhedron, points on the flat parts of the faces stay where they are
+            for (size_t i = 0; i != offsets.size(); ++i)
+            {
+                if (offsets[i] - dot(normals[i], centroid) <= blunt) throw std::string("blunt is larger than the polyhedron");
+                offsets[i] -= blunt;
+            }
+            for (vec3& p : mesh.vertices)
+            {
+                vec3 q = closestpoint(p, normals, offsets);
+                vec3 d = p - q;
+                if (d.length() > 1e-12*blunt) p = q + normalize(d)*blunt;
+            }
+        }
+
+        shapetemplate st;
+        for (vec3 const& p : mesh.vertices)
+        {
+            vec3 q = centroid + (p - centroid)*shrink;
+            st.addpoint(q.x, q.y, q.z);
+        }
+        return st;
+    };
+
+    // projection of p onto the intersection of the half spaces n.x <= d by dykstra's alternating projections
+    static vec3 closestpoint(vec3 const& p, std::vector<vec3> const& normals, std::vector<double> const& offsets)
+    {
+        vec3 x = p;
+        std::vector<vec3> increments(normals.size(), vec3{0, 0, 0});
+        for (unsigned int sweep = 0; sweep != 1000; ++sweep)
+        {
+            double change = 0;
+            for (size_t i = 0; i != normals.size(); ++i)
+            {
+                vec3 z = x + increments[i];
+                double violation = dot(normals[i], z) - offsets[i];
+                vec3 y = (violation > 0) ? z - normals[i]*violation : z;
+                increments[i] = z - y;
+                change += (y - x).length();
+                x = y;
+            }
+            if (change < 1e-14) break;
+        }
+        return x;
+    };
+};
+
+#endif
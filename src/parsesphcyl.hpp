@@ -27,9 +27,19 @@ The development of Pomelo took place at the Friedrich-Alexander University of Er
 #include <iostream>
 #include <vector>
 #include <cmath>
+#include <algorithm>
 #include "pointpattern.hpp"
 #include "splitstring.hpp"
-#include "GenericMatrix.h"
+#include "shapetemplate.hpp"
+#include "vec3.hpp"
+#include "adaptivesampling.hpp"
+
+// spherocylinder with radius r and length l of the cylinder part, placed by t
+struct sphcylinder
+{
+    double r, l;
+    rigidtransform t;
+};
 
 class parsesphcyl
 {
@@ -43,12 +53,18 @@ public:
     double shrink;
     int stepsTheta;
     int stepsPhi;
+    bool fibonacci;     // sample spheres (caps) with a Fibonacci lattice instead of the theta/phi grid
+    samplingdensity density;    // target spacing / chord tolerance, if set the resolution no longer depends on the steps
+    samplingdensity forceddensity;  // replaces the density of the input file if set, used for the levels of the convergence study
     int stepsZ;
+    std::vector<sphcylinder> spherocylinders;
+    bool shapesonly;    // only store the spherocylinders without spawning surface points, used for the voxel grid
     bool xpbc;
     bool ypbc;
     bool zpbc;
+    bool verbose;
 
-    parsesphcyl () : xmin(0),  ymin(0), zmin(0), xmax(0) ,ymax(0), zmax(0), shrink(0.95), stepsTheta(10), stepsPhi(10),  stepsZ(10), xpbc(false), ypbc(false), zpbc(false)
+    parsesphcyl () : xmin(0),  ymin(0), zmin(0), xmax(0) ,ymax(0), zmax(0), shrink(0.95), stepsTheta(10), stepsPhi(10), fibonacci(false),  stepsZ(10), shapesonly(false), xpbc(false), ypbc(false), zpbc(false), verbose(true)
     {};
 
     void parse(std::string const filename, pointpattern& pp)
@@ -59,6 +75,13 @@ public:
         {
             throw std::string("cannot open xyz input file");
         }
+        parse(infile, pp);
+    };
+
+    // the whole stream is one frame (used for trajectories), the spherocylinders of the last call are replaced
+    void parse(std::istream& infile, pointpattern& pp)
+    {
+        spherocylinders.clear();
         std::string line = "";
         unsigned long linesloaded = 0;
         splitstring commentline;
@@ -114,7 +137,7 @@ public:
                 if (pbcsplit[1].find("periodic_cuboidal") != std::string::npos)
                 {
                     xpbc = ypbc = zpbc = true;
-                    std::cout << "xyz parser boundaries: " << pbcsplit[1] << std::endl;
+                    if (verbose) std::cout << "xyz parser boundaries: " << pbcsplit[1] << std::endl;
                 }
             }
             else if (s.find("shrink") != std::string::npos)
@@ -133,6 +156,33 @@ public:
                     throw std::string("cannot parse parameters from XYZ file");
                 stepsTheta = std::stoi(stepsThetaSplit[1]);
             }
+            else if (s.find("sampling") != std::string::npos)
+            {
+                splitstring split (s.c_str());
+                std::vector<std::string> samplingsplit = split.split('=');
+                if (samplingsplit.size() != 2)
+                    throw std::string("cannot parse parameters from XYZ file");
+                fibonacci = (samplingsplit[1].find("fibonacci") != std::string::npos);
+                if (verbose) std::cout << "sampling: " << (fibonacci ? "fibonacci" : "grid") << std::endl;
+            }
+            else if (s.find("spacing") != std::string::npos)
+            {
+                splitstring split (s.c_str());
+                std::vector<std::string> spacingsplit = split.split('=');
+                if (spacingsplit.size() != 2)
+                    throw std::string("cannot parse parameters from XYZ file");
+                density.spacing = std::stod(spacingsplit[1]);
+                if (verbose) std::cout << "spacing: " << density.spacing << std::endl;
+            }
+            else if (s.find("tolerance") != std::string::npos)
+            {
+                splitstring split (s.c_str());
+                std::vector<std::string> tolerancesplit = split.split('=');
+                if (tolerancesplit.size() != 2)
+                    throw std::string("cannot parse parameters from XYZ file");
+                density.tolerance = std::stod(tolerancesplit[1]);
+                if (verbose) std::cout << "tolerance: " << density.tolerance << std::endl;
+            }
             else if (s.find("stepsphi") != std::string::npos)
             {
                 splitstring split (s.c_str());
@@ -172,86 +222,132 @@ public:
 
             linesloaded++;
 
-            double a11 = 1;
-            double a22 = 1;
-            double a33 = 1;
-            double a12 = 0;
-            double a13 = 0;
-            double a21 = 0;
-            double a23 = 0;
-            double a31 = 0;
-            double a32 = 0;
+            // the body z axis is the orientation, the body x axis lies in the plane of the orientation and the z axis
+            mat3 rotation = mat3::identity();
             if(az*az != 1)
             {
-                double sqrtz = 1.0/sqrt(1.0-az*az);;
-                a11 = ax*az*sqrtz;
-                a21 = ay*az*sqrtz;
-                a31 = -1.0/sqrtz;
-                a12 = -ay*sqrtz;
-                a22 = ax*sqrtz;
-                a32 = 0;
-                a13 = ax;
-                a23 = ay;
-                a33 = az;
+                double sqrtz = 1.0/sqrt(1.0-az*az);
+                vec3 e1{ax*az*sqrtz, ay*az*sqrtz, -1.0/sqrtz};
+                vec3 e2{-ay*sqrtz, ax*sqrtz, 0};
+                rotation = mat3::fromcolumns(e1, e2, vec3{ax, ay, az});
             }
 
-            matrix rotate(a11, a21, a31, a12, a22, a32, a13, a23, a33);
+            sphcylinder c;
+            c.r = r;
+            c.l = l;
+            c.t.setlabel(linesloaded);
+            c.t.r = rotation;
+            c.t.settranslation(x, y, z);
+            spherocylinders.push_back(c);
+        }
+        if (verbose) std::cout << "parsed "  << linesloaded << " lines" << std::endl;
+        if (shapesonly) return;
+        sample(pp);
+        if (verbose) std::cout << "distinct shapes: " << templates.size() << std::endl;
+    };
+
+    // surface points of the parsed spherocylinders, called again after changing forceddensity to resample them without reading the file
+    void sample(pointpattern& pp)
+    {
+        if (forceddensity.active()) density = forceddensity;
 
-            // spawn cylinder part first
-            for (int i = 0; i != stepsPhi; ++i)
-            for (int j = 0; j != stepsZ; ++j)
+        // the templates are kept for the next frame of a trajectory as long as the sampling does not change
+        std::vector<double> sampling = {shrink, double(stepsTheta), double(stepsPhi), double(stepsZ), double(fibonacci), density.spacing, density.tolerance};
+        if (sampling != templatesampling)
+        {
+            templates = shapetemplatecache();
+            templatesampling = sampling;
+        }
+        for (sphcylinder const& c : spherocylinders)
+        {
+            // all spherocylinders with the same radius and length share one surface triangulation
+            shapekey k;
+            k.add(c.r);
+            k.add(c.l);
+            shapetemplate const* s = templates.find(k);
+            if (s == nullptr)
             {
-                double deltaPhi = 2*M_PI/stepsPhi;
-                double deltaZ = l/stepsZ;
+                s = &templates.insert(k, createtemplate(c.r, c.l));
+            }
+            c.t.apply(*s, pp);
+        }
+    };
 
-                double phi = 0 + i * deltaPhi;
+private:
+    shapetemplatecache templates;
+    std::vector<double> templatesampling;
 
-                double xp = std::cos(phi) * r * shrink;
-                double yp = std::sin(phi) * r * shrink;
-                double zp = -l/2.0 + j * deltaZ;
-                
-                svec p(xp, yp, zp);
-                p = rotate*p;
-                pp.addpoint(linesloaded, p.x() + x, p.y() + y, p.z() + z);
-            }
-            
-            std::cout << "cylinder points: " << pp.points.size() << std::endl;
+    // surface triangulation of a spherocylinder with radius r and length l of the cylinder part along the z axis
+    shapetemplate createtemplate(double r, double l) const
+    {
+        shapetemplate s;
 
-            // TODO rotate point to correct orientation
-            
+        int cylinderStepsPhi = stepsPhi;
+        int cylinderStepsZ = stepsZ;
+        if (density.active())
+        {
+            // cylinder and caps share the radius of curvature r*shrink
+            double h = density.at(r*shrink);
+            cylinderStepsPhi = std::max(3, static_cast<int>(std::ceil(2*M_PI*r*shrink/h)));
+            cylinderStepsZ = std::max(1, static_cast<int>(std::ceil(l/h)));
+        }
 
-            for(int i = 0; i != stepsTheta; ++i)
-            for(int j = 0; j <= stepsPhi; ++j)
-            {
+        // spawn cylinder part first
+        for (int i = 0; i != cylinderStepsPhi; ++i)
+        for (int j = 0; j != cylinderStepsZ; ++j)
+        {
+            double deltaPhi = 2*M_PI/cylinderStepsPhi;
+            double deltaZ = l/cylinderStepsZ;
 
+            double phi = 0 + i * deltaPhi;
 
-                double theta = std::acos( static_cast<double>(j) * (2.0/stepsPhi) - 1.0);
-                double phi   = static_cast<double>(i) * (1.0/stepsTheta) * std::acos(-1)*2.0;                
+            double xp = std::cos(phi) * r * shrink;
+            double yp = std::sin(phi) * r * shrink;
+            double zp = -l/2.0 + j * deltaZ;
+            
+            s.addpoint(xp, yp, zp);
+        }
 
-                double xp =  cos(phi) * sin(theta)*(r*shrink);
-                double yp =  sin(phi) * sin(theta)*(r*shrink);
-                double zp =  cos(theta)*(r * shrink);
-                if (zp < 0 )
-                { 
-                    zp -= l/2.0; 
-                }
-                else if (zp > 0) 
-                {
-                    zp += l/2.0; 
-                }
-                else 
-                {
-                    std::cout << "no point added" << std::endl;
-                    continue;
-                }
-                
-                svec p(xp, yp, zp);
-                p = rotate*p;
-                pp.addpoint(linesloaded, p.x() + x, p.y() + y, p.z() + z);
+        // spawn the caps, the upper hemisphere is shifted to +l/2 and the lower one to -l/2
+        if (fibonacci || density.active())
+        {
+            unsigned int n = stepsTheta*(stepsPhi-1) + 2;
+            if (density.active()) n = pointsforspacing(4.0*M_PI*r*shrink*r*shrink, density.at(r*shrink));
+            std::vector<vec3> unit = fibonaccisphere(n);
+            for (auto it = unit.begin(); it != unit.end(); ++it)
+            {
+                vec3 p = *it*(r*shrink);
+                if (p.z < 0) p.z -= l/2.0;
+                else if (p.z > 0) p.z += l/2.0;
+                else continue;
+                s.addpoint(p);
             }
+            return s;
+        }
+
+        for(int i = 0; i != stepsTheta; ++i)
+        for(int j = 0; j <= stepsPhi; ++j)
+        {
+            double theta = std::acos( static_cast<double>(j) * (2.0/stepsPhi) - 1.0);
+            double phi   = static_cast<double>(i) * (1.0/stepsTheta) * std::acos(-1)*2.0;                
 
+            vec3 p = vec3{cos(phi) * sin(theta), sin(phi) * sin(theta), cos(theta)}*(r*shrink);
+            if (p.z < 0 )
+            { 
+                p.z -= l/2.0; 
+            }
+            else if (p.z > 0) 
+            {
+                p.z += l/2.0; 
+            }
+            else 
+            {
+                continue;
+            }
+            
+            s.addpoint(p);
         }
-        std::cout << "parsed "  << linesloaded << " lines" << std::endl;
+        return s;
     };
 };
 
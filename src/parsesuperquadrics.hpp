@@ -0,0 +1,318 @@
+/* 
+Copyright 2016 Simon Weis and Philipp Schoenhoefer
+
+This file is part of Pomelo.
+
+Pomelo is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Pomelo is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Pomelo.  If not, see <http://www.gnu.org/licenses/>.
+
+The development of Pomelo took place at the Friedrich-Alexander University of Erlangen and was funded by the German Research Foundation (DFG) Forschergruppe FOR1548 "Geometry and Physics of Spatial Random Systems" (GPSRS). 
+*/
+#ifndef PARSESUPERQUADRICS_H_GUARD_123456
+#define PARSESUPERQUADRICS_H_GUARD_123456
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include "pointpattern.hpp"
+#include "splitstring.hpp"
+#include "shapetemplate.hpp"
+#include "vec3.hpp"
+#include "adaptivesampling.hpp"
+
+// superquadric (superellipsoid) with semi-axes a, b, c and the shape exponents e1 (latitude) and e2 (longitude)
+//   (|x/a|^(2/e2) + |y/b|^(2/e2))^(e2/e1) + |z/c|^(2/e1) = 1
+// e1 = e2 = 1 is the ellipsoid, smaller exponents are boxier (a superball with exponent p has e1 = e2 = 2/p)
+struct superquadric
+{
+    double a, b, c;
+    double e1, e2;
+
+    // inside-outside function, homogeneous of degree 2/e1
+    double implicit(vec3 const& p) const
+    {
+        double g = std::pow(std::fabs(p.x/a), 2.0/e2) + std::pow(std::fabs(p.y/b), 2.0/e2);
+        return std::pow(g, e2/e1) + std::pow(std::fabs(p.z/c), 2.0/e1);
+    };
+
+    // outward unit normal at the surface point p
+    vec3 normal(vec3 const& p) const
+    {
+        double g = std::pow(std::fabs(p.x/a), 2.0/e2) + std::pow(std::fabs(p.y/b), 2.0/e2);
+        double f = (g > 0) ? std::pow(g, e2/e1 - 1.0)/e1 : 0;
+        vec3 n{
+            f * std::pow(std::fabs(p.x/a), 2.0/e2 - 1.0) * signum(p.x) / a,
+            f * std::pow(std::fabs(p.y/b), 2.0/e2 - 1.0) * signum(p.y) / b,
+            std::pow(std::fabs(p.z/c), 2.0/e1 - 1.0) * signum(p.z) / (c*e1)};
+        return normalize(n);
+    };
+
+    // surface point in the direction of u from the center
+    vec3 radial(vec3 const& u) const
+    {
+        return u * std::pow(implicit(u), -0.5*e1);
+    };
+
+    // surface point of the parametrization by the polar angle theta and the azimuth phi
+    vec3 parametric(double theta, double phi) const
+    {
+        double s = signedpow(std::sin(theta), e1);
+        return vec3{a * s * signedpow(std::cos(phi), e2), b * s * signedpow(std::sin(phi), e2), c * signedpow(std::cos(theta), e1)};
+    };
+
+private:
+    static double signum(double v)
+    {
+        return (v > 0) - (v < 0);
+    };
+
+    static double signedpow(double v, double e)
+    {
+        return signum(v) * std::pow(std::fabs(v), e);
+    };
+};
+
+
+class parsesuperquadric
+{
+public:
+    double xmin;
+    double ymin;
+    double zmin;
+    double xmax;
+    double ymax;
+    double zmax;
+    double shrink;      // distance by which the surface is shifted inwards along the normal
+    unsigned int steps;
+    samplingdensity density;    // if set, the points are spaced uniformly instead of on the steps grid
+    samplingdensity forceddensity;  // replaces the density of the input file if set, used for the levels of the convergence study
+    bool boxset;
+    std::vector<std::pair<superquadric, rigidtransform> > particles;
+    bool xpbc;
+    bool ypbc;
+    bool zpbc;
+    bool verbose;
+
+    parsesuperquadric () : xmin(0),  ymin(0), zmin(0), xmax(0) ,ymax(0), zmax(0), shrink(0), steps(10), boxset(false), xpbc(false), ypbc(false), zpbc(false), verbose(true)
+    {};
+
+    // one particle per line: label cx cy cz a x1 y1 z1 b x2 y2 z2 c x3 y3 z3 e1 e2
+    // like in the ellip files, (x1 y1 z1), (x2 y2 z2) and (x3 y3 z3) are the rows of the rotation matrix
+    void parse(std::string const filename, pointpattern& pp)
+    {
+        if (verbose) std::cout << "parse superquadric file" << std::endl;
+        std::ifstream infile;
+        infile.open(filename);
+        if (infile.fail())
+        {
+            throw std::string("cannot open superquadric input file");
+        }
+        parse(infile, pp);
+    };
+
+    // the whole stream is one frame (used for trajectories), the particles of the last call are replaced
+    void parse(std::istream& infile, pointpattern& pp)
+    {
+        particles.clear();
+        std::string line = "";
+        unsigned long linesloaded = 0;
+
+        while(std::getline(infile, line))   // parse lines
+        {
+            if(line.find('#') != std::string::npos)
+            {
+                if (line.find('=') == std::string::npos) continue;
+                splitstring split (line.c_str());
+                std::vector<std::string> valuesplit = split.split('=');
+                if (valuesplit.size() != 2)
+                {
+                    throw std::string ("cannot parse parameter line in superquadric file: " + line);
+                }
+                if (line.find("boundary_condition") != std::string::npos)
+                {
+                    xpbc = ypbc = zpbc = (valuesplit[1].find("periodic_cuboidal") != std::string::npos);
+                    if (verbose) std::cout << "superquadric parser boundaries: " << valuesplit[1] << std::endl;
+                }
+                else if (line.find("nx") != std::string::npos)
+                {
+                    xmax = std::stod(valuesplit[1]);
+                    boxset = true;
+                }
+                else if (line.find("ny") != std::string::npos)
+                {
+                    ymax = std::stod(valuesplit[1]);
+                    boxset = true;
+                }
+                else if (line.find("nz") != std::string::npos)
+                {
+                    zmax = std::stod(valuesplit[1]);
+                    boxset = true;
+                }
+                else if (line.find("shrink") != std::string::npos)
+                {
+                    shrink = std::stod(valuesplit[1]);
+                    if (verbose) std::cout << "shrink = " << shrink << std::endl;
+                }
+                else if (line.find("spacing") != std::string::npos)
+                {
+                    density.spacing = std::stod(valuesplit[1]);
+                    if (verbose) std::cout << "spacing: " << density.spacing << std::endl;
+                }
+                else if (line.find("steps") != std::string::npos)
+                {
+                    steps = static_cast<unsigned int>(std::stod(valuesplit[1]));
+                }
+                continue;
+            }
+
+            if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+            std::istringstream iss(line);
+            unsigned long l;
+            double cx, cy, cz;
+            double x1, y1, z1, x2, y2, z2, x3, y3, z3;
+            superquadric s;
+            if (!(iss >> l >> cx >> cy >> cz >> s.a >> x1 >> y1 >> z1 >> s.b >> x2 >> y2 >> z2 >> s.c >> x3 >> y3 >> z3 >> s.e1 >> s.e2))
+            {
+                std::cerr << "error parsing one line in superquadric file" << std::endl;
+                std::cout << line << std::endl;
+                break;
+            }
+            if (s.e1 <= 0 || s.e2 <= 0 || s.e1 > 2 || s.e2 > 2)
+                throw std::string("superquadric exponents have to be in (0, 2]");
+            if (shrink >= std::min(s.a, std::min(s.b, s.c)))
+                throw std::string("superquadric shrink is larger than the smallest semi-axis");
+            linesloaded++;
+
+            rigidtransform t;
+            t.setlabel(l);
+            t.setorthonormalrotation(x1, y1, z1, x2, y2, z2, x3, y3, z3);
+            t.settranslation(cx, cy, cz);
+            particles.push_back(std::make_pair(s, t));
+        }
+        if (verbose) std::cout << "parsed "  << linesloaded << " lines" << std::endl;
+        sample(pp);
+        if (verbose) std::cout << "distinct shapes: " << templates.size() << std::endl;
+        if (verbose) std::cout << "created N = " << pp.points.size() << " points"  << std::endl;
+        if (pp.points.empty()) throw std::string("no particles in superquadric file");
+
+        if (!boxset)
+        {
+            if (verbose) std::cout << "setting boundaries "<< std::endl;
+            xmin = ymin = zmin = std::numeric_limits<double>::max();
+            xmax = ymax = zmax = std::numeric_limits<double>::lowest();
+            for (point const& p : pp.points)
+            {
+                xmin = std::min(xmin, p.x); xmax = std::max(xmax, p.x);
+                ymin = std::min(ymin, p.y); ymax = std::max(ymax, p.y);
+                zmin = std::min(zmin, p.z); zmax = std::max(zmax, p.z);
+            }
+        }
+    };
+
+    // surface points of the parsed superquadrics, called again after changing forceddensity to resample them without reading the file
+    void sample(pointpattern& pp)
+    {
+        // the templates are kept for the next frame of a trajectory as long as the sampling does not change
+        samplingdensity const& d = forceddensity.active() ? forceddensity : density;
+        std::vector<double> sampling = {shrink, double(steps), d.spacing, d.tolerance};
+        if (sampling != templatesampling)
+        {
+            templates = shapetemplatecache();
+            templatesampling = sampling;
+        }
+        for (auto const& p : particles)
+        {
+            superquadric const& s = p.first;
+            // all superquadrics with the same semi-axes and exponents share one surface triangulation
+            shapekey k;
+            k.add(s.a);
+            k.add(s.b);
+            k.add(s.c);
+            k.add(s.e1);
+            k.add(s.e2);
+            shapetemplate const* st = templates.find(k);
+            if (st == nullptr)
+            {
+                st = &templates.insert(k, createtemplate(s));
+            }
+            p.second.apply(*st, pp);
+        }
+    };
+
+private:
+    shapetemplatecache templates;
+    std::vector<double> templatesampling;
+
+    // surface triangulation of one superquadric in its body frame, shifted inwards by shrink along the surface normal
+    shapetemplate createtemplate(superquadric const& s) const
+    {
+        std::vector<vec3> points;
+        samplingdensity const& d = forceddensity.active() ? forceddensity : density;
+        if (d.active())
+        {
+            // dense candidates, thinned to the spacing. The radial projection of the unit sphere covers the flat
+            // sides well, the parametrization covers the strongly curved edges and corners of boxy shapes
+            double h = d.at(std::numeric_limits<double>::max());
+            double rmax = std::sqrt(s.a*s.a + s.b*s.b + s.c*s.c);
+            std::vector<vec3> unit = fibonaccisphere(pointsforspacing(4.0*M_PI, 0.25*h/rmax));
+            std::vector<vec3> candidates;
+            candidates.reserve(2*unit.size());
+            for (vec3 const& u : unit)
+            {
+                candidates.push_back(s.radial(u));
+            }
+            for (vec3 const& u : unit)
+            {
+                candidates.push_back(s.parametric(std::acos(std::max(-1.0, std::min(1.0, u.z))), std::atan2(u.y, u.x)));
+            }
+            std::vector<double> spacing(candidates.size(), h);
+            for (unsigned int i : thinbyspacing(candidates, spacing))
+            {
+                points.push_back(candidates[i]);
+            }
+        }
+        else
+        {
+            // the theta phi grid of the ellipsoids, plus the two poles
+            points.push_back(s.parametric(0, 0));
+            points.push_back(s.parametric(M_PI, 0));
+            double d_theta = M_PI/(2.*static_cast<double>(steps));
+            unsigned int theta_steps = 2*steps;
+            for(unsigned int i = 1; i < theta_steps; i++ )
+            {
+                double theta = static_cast<double>(i)*d_theta;
+                unsigned int phi_steps = 4*steps*fabs(sin(theta));
+                double d_phi = 2.*M_PI/(static_cast<double>(phi_steps));
+                for(unsigned int j = 0; j < phi_steps; j++)
+                {
+                    points.push_back(s.parametric(theta, j*d_phi));
+                }
+            }
+        }
+
+        shapetemplate st;
+        for (vec3 p : points)
+        {
+            if (shrink > 0) p = p - s.normal(p) * shrink;
+            st.addpoint(p.x, p.y, p.z);
+        }
+        return st;
+    };
+};
+
+#endif
@@ -28,9 +28,8 @@ The development of Pomelo took place at the Friedrich-Alexander University of Er
 #include <vector>
 #include <algorithm>
 #include "pointpattern.hpp"
-#include "duplicationremover.hpp"
 #include "splitstring.hpp"
-#include "triangle.hpp"
+#include "tetrahedra.hpp"
 
 class parsetetra
 {
@@ -41,11 +40,13 @@ public:
     double xmax;
     double ymax;
     double zmax;
+    std::vector<std::vector<point> > tetrahedra;   // the four corners of every parsed tetrahedron
+    bool shapesonly;    // only store the tetrahedra without spawning surface points, used for the voxel grid
     bool xpbc;
     bool ypbc;
     bool zpbc;
 
-    parsetetra () : xmin(0),  ymin(0), zmin(0), xmax(0) ,ymax(0), zmax(0), xpbc(false), ypbc(false), zpbc(false)
+    parsetetra () : xmin(0),  ymin(0), zmin(0), xmax(0) ,ymax(0), zmax(0), shapesonly(false), xpbc(false), ypbc(false), zpbc(false)
     {};
 
     void parse(std::string const filename, pointpattern& pp, double shrink = 0.95, int depth = 3)
@@ -105,38 +106,9 @@ public:
             yvals.push_back(p4.y);
             zvals.push_back(p4.z);
 
-            std::vector<point> p = {p1,p2,p3,p4};
-            dumbShrink( p, shrink);
-
-            //std::cout << "points loaded" << std::endl;
-            triangle t1 (p[0], p[1], p[2]); 
-            triangle t2 (p[0], p[1], p[3]); 
-            triangle t3 (p[0], p[2], p[3]); 
-            triangle t4 (p[1], p[2], p[3]); 
-            //std::cout << "triangles created" << std::endl;
-
-            std::vector<triangle> list = {t1, t2, t3, t4}; 
-
-            //std::cout << "subdivision started" << std::endl;
-            triangle::recusiveSubdivide(depth, list);
-            //std::cout << "subdivision ended" << std::endl;
-            
-            // add the surface points to a pointpattern for this tetrahedra first to make some duplicationchecks
-            pointpattern pptetra; 
-            for(triangle t : list)
-            {
-                for(point x : t.p)
-                {
-                    pptetra.addpoint(x.l, x.x, x.y, x.z);
-                }
-            }
-            
-            pptetra.removeduplicates(1e-9); 
-            for ( point x : pptetra.points)
-            {
-                pp.addpoint(x.l, x.x, x.y, x.z);
-            }
+            tetrahedra.push_back({p1,p2,p3,p4});
         }
+        if (!shapesonly) sample(pp, shrink, depth);
 
         std::cout << "parsed "  << linesloaded << " lines" << std::endl;
 
@@ -151,7 +123,23 @@ public:
         zmax = *std::max_element(zvals.begin(), zvals.end());
 
     };
-private:
+
+    // surface points of the parsed tetrahedra, called again with another depth to resample them without reading the file
+    void sample(pointpattern& pp, double shrink, int depth)
+    {
+        // subdivided surface of the unit tetrahedron, shared by all particles
+        tetrahedrontemplate surface(depth);
+
+        for (std::vector<point> p : tetrahedra)
+        {
+            dumbShrink( p, shrink);
+
+            // add the surface points of this tetrahedra, they are unique by construction
+            surface.create(p, pp.points);
+        }
+    };
+
+    // scale the corners about their center of mass by f
     static void dumbShrink (std::vector<point>& p, double f  = 0.95)
     {
         //std::cout << "dumbshrink: using shrink of " << f << std::endl;
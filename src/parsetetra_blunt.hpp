@@ -28,9 +28,8 @@ The development of Pomelo took place at the Friedrich-Alexander University of Er
 #include <vector>
 #include <algorithm>
 #include "pointpattern.hpp"
-#include "duplicationremover.hpp"
 #include "splitstring.hpp"
-#include "triangle.hpp"
+#include "tetrahedra.hpp"
 
 class parsetetrablunt
 {
@@ -41,6 +40,7 @@ public:
     double xmax;
     double ymax;
     double zmax;
+    std::vector<std::vector<point> > tetrahedra;   // the four corners of every parsed tetrahedron
     bool xpbc;
     bool ypbc;
     bool zpbc;
@@ -105,45 +105,9 @@ public:
             yvals.push_back(p4.y);
             zvals.push_back(p4.z);
 
-            std::vector<point> p = {p1,p2,p3,p4};
-
-            //std::cout << "points loaded" << std::endl;
-            triangle t1 (p[0], p[1], p[2]); 
-            triangle t2 (p[0], p[1], p[3]); 
-            triangle t3 (p[0], p[2], p[3]); 
-            triangle t4 (p[1], p[2], p[3]); 
-
-            //std::cout << "triangles created" << std::endl;
-
-            std::vector<triangle> list = {t1, t2, t3, t4}; 
-
-            //std::cout << "subdivision started" << std::endl;
-            triangle::recusiveSubdivide(depth, list);
-            //std::cout << "subdivision ended" << std::endl;
-            
-
-            // add the surface points to a pointpattern for this tetrahedra first to make some duplicationchecks
-            pointpattern pptetra; 
-            for(triangle tri : list)
-            {
-                for(point x : tri.p)
-                {
-                    pptetra.addpoint(x.l, x.x, x.y, x.z);
-                }
-            }
-            
-            pptetra.removeduplicates(1e-9); 
-
-            double l = std::sqrt( (p[0].x-p[1].x) * (p[0].x-p[1].x) + (p[0].y-p[1].y) * (p[0].y-p[1].y) + (p[0].z-p[1].z) * (p[0].z-p[1].z) );
-
-            bluntEdges(pptetra.points, l);
-            dumbShrink( pptetra.points, shrink);
-
-            for ( point x : pptetra.points)
-            {
-                pp.addpoint(x.l, x.x, x.y, x.z);
-            }
+            tetrahedra.push_back({p1,p2,p3,p4});
         }
+        sample(pp, shrink, depth);
 
         std::cout << "parsed "  << linesloaded << " lines" << std::endl;
 
@@ -158,6 +122,27 @@ public:
         zmax = *std::max_element(zvals.begin(), zvals.end());
 
     };
+
+    // surface points of the parsed tetrahedra, called again with another depth to resample them without reading the file
+    void sample(pointpattern& pp, double shrink, int depth)
+    {
+        // subdivided surface of the unit tetrahedron, shared by all particles
+        tetrahedrontemplate surface(depth);
+
+        for (std::vector<point> const& p : tetrahedra)
+        {
+            // surface points of this tetrahedra, they are unique by construction
+            std::vector<point> points;
+            surface.create(p, points);
+
+            double l = std::sqrt( (p[0].x-p[1].x) * (p[0].x-p[1].x) + (p[0].y-p[1].y) * (p[0].y-p[1].y) + (p[0].z-p[1].z) * (p[0].z-p[1].z) );
+
+            bluntEdges(points, l);
+            dumbShrink(points, shrink);
+
+            pp.points.insert(pp.points.end(), points.begin(), points.end());
+        }
+    };
 private:
     static void dumbShrink (std::vector<point>& p, double f  = 0.95)
     {
@@ -41,8 +41,9 @@ public:
     bool xpbc;
     bool ypbc;
     bool zpbc;
+    bool verbose;
 
-    parsexyz () : xmin(0),  ymin(0), zmin(0), xmax(0) ,ymax(0), zmax(0), xpbc(false), ypbc(false), zpbc(false)
+    parsexyz () : xmin(0),  ymin(0), zmin(0), xmax(0) ,ymax(0), zmax(0), xpbc(false), ypbc(false), zpbc(false), verbose(true)
     {};
     void parse(std::string const filename, pointpattern& pp)
     {
@@ -52,6 +53,12 @@ public:
         {
             throw std::string("cannot open xyz input file");
         }
+        parse(infile, pp);
+    };
+
+    // one frame, the stream ends after its last particle (used for trajectories)
+    void parse(std::istream& infile, pointpattern& pp)
+    {
         std::string line = "";
         unsigned long linesloaded = 0;
         std::getline(infile, line); // ignore first line
@@ -70,7 +77,7 @@ public:
                     throw std::string("cannot parse parameters from XYZ file");
                 
                 double v = std::stod(boxsplit[1]);
-                std::cout << "xyz parser boxsize: " << v << std::endl;
+                if (verbose) std::cout << "xyz parser boxsize: " << v << std::endl;
                 xmin = 0;
                 ymin = 0;
                 zmin = 0;
@@ -89,7 +96,7 @@ public:
                 if (pbcsplit[1].find("periodic_cuboidal") != std::string::npos)
                 {
                     xpbc = ypbc = zpbc = true;
-                    std::cout << "xyz parser boundaries: " << pbcsplit[1] << std::endl;
+                    if (verbose) std::cout << "xyz parser boundaries: " << pbcsplit[1] << std::endl;
                 }
             }
 
@@ -109,7 +116,7 @@ public:
             linesloaded++;
             pp.addpoint(linesloaded, x,y,z);
         }
-        std::cout << "parsed "  << linesloaded << " lines" << std::endl;
+        if (verbose) std::cout << "parsed "  << linesloaded << " lines" << std::endl;
     };
 };
 
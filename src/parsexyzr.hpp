@@ -29,6 +29,14 @@ The development of Pomelo took place at the Friedrich-Alexander University of Er
 #include <cmath>
 #include "pointpattern.hpp"
 #include "splitstring.hpp"
+#include "shapetemplate.hpp"
+#include "vec3.hpp"
+#include "adaptivesampling.hpp"
+
+struct xyzrsphere
+{
+    double x, y, z, r;
+};
 
 class parsexyzr
 {
@@ -42,11 +50,18 @@ public:
     double shrink;
     int stepsTheta;
     int stepsPhi;
+    bool fibonacci;     // sample spheres (caps) with a Fibonacci lattice instead of the theta/phi grid
+    samplingdensity density;    // target spacing / chord tolerance, if set the resolution no longer depends on the steps
+    bool centersonly;   // only spawn the centers and store the radii, used for the laguerre tessellation
+    std::vector<double> radii;
+    std::vector<xyzrsphere> spheres;    // of the last parsed file or frame, sphere i has label i+1
+    samplingdensity forceddensity;  // replaces the density of the input file if set, used for the levels of the convergence study
     bool xpbc;
     bool ypbc;
     bool zpbc;
+    bool verbose;
 
-    parsexyzr () : xmin(0),  ymin(0), zmin(0), xmax(0) ,ymax(0), zmax(0), shrink(0.95), stepsTheta(10), stepsPhi(10),  xpbc(false), ypbc(false), zpbc(false)
+    parsexyzr () : xmin(0),  ymin(0), zmin(0), xmax(0) ,ymax(0), zmax(0), shrink(0.95), stepsTheta(10), stepsPhi(10), fibonacci(false), centersonly(false),  xpbc(false), ypbc(false), zpbc(false), verbose(true)
     {};
     void parse(std::string const filename, pointpattern& pp)
     {
@@ -56,6 +71,12 @@ public:
         {
             throw std::string("cannot open xyzr input file");
         }
+        parse(infile, pp);
+    };
+
+    // one frame, the stream ends after its last particle (used for trajectories)
+    void parse(std::istream& infile, pointpattern& pp)
+    {
         std::string line = "";
         unsigned long linesloaded = 0;
         std::getline(infile, line); // ignore first line
@@ -74,7 +95,7 @@ public:
                     throw std::string("cannot parse parameters from XYZ file");
                 
                 double v = std::stod(boxsplit[1]);
-                std::cout << "xyzr parser boxsize: " << v << std::endl;
+                if (verbose) std::cout << "xyzr parser boxsize: " << v << std::endl;
                 xmin = 0;
                 ymin = 0;
                 zmin = 0;
@@ -93,7 +114,7 @@ public:
                 if (pbcsplit[1].find("periodic_cuboidal") != std::string::npos)
                 {
                     xpbc = ypbc = zpbc = true;
-                    std::cout << "xyzr parser boundaries: " << pbcsplit[1] << std::endl;
+                    if (verbose) std::cout << "xyzr parser boundaries: " << pbcsplit[1] << std::endl;
                 }
             }
             else if (s.find("shrink") != std::string::npos)
@@ -103,7 +124,7 @@ public:
                 if (shrinksplit.size() != 2)
                     throw std::string("cannot parse parameters from XYZ file");
                 shrink = std::stod(shrinksplit[1]);
-                std::cout << "loaded a shrink value of " << shrink << std::endl;
+                if (verbose) std::cout << "loaded a shrink value of " << shrink << std::endl;
             }
             else if (s.find("stepstheta") != std::string::npos)
             {
@@ -112,7 +133,34 @@ public:
                 if (stepsThetaSplit.size() != 2)
                     throw std::string("cannot parse parameters from XYZ file");
                 stepsTheta = std::stoi(stepsThetaSplit[1]);
-                std::cout << "stepsTheta: " << stepsTheta << std::endl;
+                if (verbose) std::cout << "stepsTheta: " << stepsTheta << std::endl;
+            }
+            else if (s.find("sampling") != std::string::npos)
+            {
+                splitstring split (s.c_str());
+                std::vector<std::string> samplingsplit = split.split('=');
+                if (samplingsplit.size() != 2)
+                    throw std::string("cannot parse parameters from XYZ file");
+                fibonacci = (samplingsplit[1].find("fibonacci") != std::string::npos);
+                if (verbose) std::cout << "sampling: " << (fibonacci ? "fibonacci" : "grid") << std::endl;
+            }
+            else if (s.find("spacing") != std::string::npos)
+            {
+                splitstring split (s.c_str());
+                std::vector<std::string> spacingsplit = split.split('=');
+                if (spacingsplit.size() != 2)
+                    throw std::string("cannot parse parameters from XYZ file");
+                density.spacing = std::stod(spacingsplit[1]);
+                if (verbose) std::cout << "spacing: " << density.spacing << std::endl;
+            }
+            else if (s.find("tolerance") != std::string::npos)
+            {
+                splitstring split (s.c_str());
+                std::vector<std::string> tolerancesplit = split.split('=');
+                if (tolerancesplit.size() != 2)
+                    throw std::string("cannot parse parameters from XYZ file");
+                density.tolerance = std::stod(tolerancesplit[1]);
+                if (verbose) std::cout << "tolerance: " << density.tolerance << std::endl;
             }
             else if (s.find("stepsphi") != std::string::npos)
             {
@@ -121,39 +169,107 @@ public:
                 if (stepsPhiSplit.size() != 2)
                     throw std::string("cannot parse parameters from XYZ file");
                 stepsPhi = std::stoi(stepsPhiSplit[1]);
-                std::cout << "stepsPhi: " << stepsPhi << std::endl;
+                if (verbose) std::cout << "stepsPhi: " << stepsPhi << std::endl;
             }
 
         }
         
 
+        spheres.clear();
         while(std::getline(infile, line))   // parse lines
         {
             line = line.substr(2, line.size()); // remove "P "
             std::istringstream iss(line);
-            double x ,y, z, r;
-            if (!(iss >> x >> y >> z >> r))
+            xyzrsphere s;
+            if (!(iss >> s.x >> s.y >> s.z >> s.r))
             {
                 std::cerr << "error parsing one line in XYZR file" << std::endl;
                 break;
             }
             
-            if (r < shrink) std::cerr << "WARNING: Shrink (s=" << shrink << ") larger than particle (i=" << linesloaded << "9 radius (r= " << r << "). The result will be a negative radius" << std::endl;
             linesloaded++;
-            for(int i = 0; i != stepsTheta; ++i)
-            for(int j = 0; j <= stepsPhi; ++j)
+            spheres.push_back(s);
+            if (centersonly)
+            {
+                radii.push_back(s.r);
+                continue;
+            }
+            if (s.r < shrink) std::cerr << "WARNING: Shrink (s=" << shrink << ") larger than particle (i=" << linesloaded << "9 radius (r= " << s.r << "). The result will be a negative radius" << std::endl;
+        }
+        if (verbose) std::cout << "parsed "  << linesloaded << " lines" << std::endl;
+
+        sample(pp);
+        if (verbose) std::cout << "distinct radii: " << templates.size() << std::endl;
+    };
+
+    // surface points of the parsed spheres, called again after changing forceddensity to resample them without reading the file
+    void sample(pointpattern& pp)
+    {
+        if (forceddensity.active()) density = forceddensity;
+
+        // the templates are kept for the next frame of a trajectory as long as the sampling does not change
+        std::vector<double> sampling = {shrink, double(stepsTheta), double(stepsPhi), double(fibonacci), density.spacing, density.tolerance};
+        if (sampling != templatesampling)
+        {
+            templates = shapetemplatecache();
+            templatesampling = sampling;
+        }
+
+        for (size_t i = 0; i != spheres.size(); ++i)
+        {
+            xyzrsphere const& sp = spheres[i];
+            if (centersonly)
+            {
+                pp.addpoint(i+1, sp.x, sp.y, sp.z);
+                continue;
+            }
+
+            // all spheres with the same radius share one surface triangulation
+            shapekey k;
+            k.add(sp.r);
+            shapetemplate const* s = templates.find(k);
+            if (s == nullptr)
             {
-                double theta = static_cast<double>(i) * (1.0/stepsTheta) * std::acos(-1)*2.0;
-                double phi =   std::acos( static_cast<double>(j) * (2.0/stepsPhi) - 1.0);
-                //std::cout << phi << " " << theta << std::endl;
-                double xp = x + cos(theta) * sin(phi)*(r-shrink);
-                double yp = y + sin(theta) * sin(phi)*(r-shrink);
-                double zp = z + cos(phi)*(r - shrink);
-                pp.addpoint(linesloaded, xp, yp, zp);
+                s = &templates.insert(k, createtemplate(sp.r));
             }
 
+            rigidtransform t;
+            t.setlabel(i+1);
+            t.settranslation(sp.x, sp.y, sp.z);
+            t.apply(*s, pp);
+        }
+    };
+
+private:
+    shapetemplatecache templates;
+    std::vector<double> templatesampling;
+
+    // surface triangulation of a sphere with radius r around the origin
+    shapetemplate createtemplate(double r) const
+    {
+        shapetemplate s;
+        if (fibonacci || density.active())
+        {
+            // without a density, use as many points as the grid has unique points
+            unsigned int n = stepsTheta*(stepsPhi-1) + 2;
+            if (density.active()) n = pointsforspacing(4.0*M_PI*(r-shrink)*(r-shrink), density.at(r-shrink));
+            std::vector<vec3> unit = fibonaccisphere(n);
+            for (auto it = unit.begin(); it != unit.end(); ++it)
+            {
+                s.addpoint(*it*(r-shrink));
+            }
+            return s;
+        }
+
+        for(int i = 0; i != stepsTheta; ++i)
+        for(int j = 0; j <= stepsPhi; ++j)
+        {
+            double theta = static_cast<double>(i) * (1.0/stepsTheta) * std::acos(-1)*2.0;
+            double phi =   std::acos( static_cast<double>(j) * (2.0/stepsPhi) - 1.0);
+            vec3 direction{cos(theta) * sin(phi), sin(theta) * sin(phi), cos(phi)};
+            s.addpoint(direction*(r - shrink));
         }
-        std::cout << "parsed "  << linesloaded << " lines" << std::endl;
+        return s;
     };
 };
 
@@ -0,0 +1,94 @@
+/* 
+Copyright 2016 Simon Weis and Philipp Schoenhoefer
+
+This file is part of Pomelo.
+
+Pomelo is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Pomelo is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Pomelo.  If not, see <http://www.gnu.org/licenses/>.
+
+The development of Pomelo took place at the Friedrich-Alexander University of Erlangen and was funded by the German Research Foundation (DFG) Forschergruppe FOR1548 "Geometry and Physics of Spatial Random Systems" (GPSRS). 
+*/
+#ifndef POMELO_C_H_GUARD_123456
+#define POMELO_C_H_GUARD_123456
+
+#include <stddef.h>
+
+/* plain C interface of libpomelo, see libpomelo.hpp for the meaning of the arrays */
+/* every call returns a result, also on errors. pomelo_error is NULL on success and the result has to be released
+   with pomelo_free. The arrays stay valid until then */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct pomelo_result pomelo_result;
+
+typedef struct
+{
+    double xmin, xmax, ymin, ymax, zmin, zmax;
+    int xpbc, ypbc, zpbc;
+} pomelo_box;
+
+/* n surface points with x y z in xyz[3*i] ... and particle labels */
+pomelo_result* pomelo_calculate(size_t n, const double* xyz, const int* labels, const pomelo_box* box, double epsilon, int mesh);
+/* the same in a triclinic box with the tilt factors xy, xz, yz, see pomelooptions in libpomelo.hpp */
+pomelo_result* pomelo_calculate_triclinic(size_t n, const double* xyz, const int* labels, const pomelo_box* box, double xy, double xz, double yz, double epsilon, int mesh);
+/* n spheres, sphere i gets label i */
+pomelo_result* pomelo_spheres(size_t n, const double* xyz, const double* radii, double spacing, double shrink, const pomelo_box* box, int mesh);
+/* n points in the plane with x y in xy[2*i] ... */
+pomelo_result* pomelo_calculate2d(size_t n, const double* xy, const int* labels, const pomelo_box* box, int mesh);
+
+const char* pomelo_error(const pomelo_result* r);
+
+size_t pomelo_labels(const pomelo_result* r);
+const double* pomelo_volume(const pomelo_result* r);
+const unsigned long* pomelo_neighbor_offset(const pomelo_result* r);     /* pomelo_labels + 1 entries */
+const unsigned int* pomelo_neighbor(const pomelo_result* r);
+const double* pomelo_face_area(const pomelo_result* r);
+
+size_t pomelo_vertices(const pomelo_result* r);
+const double* pomelo_vertex(const pomelo_result* r);
+size_t pomelo_faces(const pomelo_result* r);
+const unsigned long* pomelo_face_offset(const pomelo_result* r);         /* pomelo_faces + 1 entries */
+const unsigned long* pomelo_face_index(const pomelo_result* r);
+const unsigned int* pomelo_face_label(const pomelo_result* r);
+
+void pomelo_free(pomelo_result* r);
+
+/* incremental diagram, see pomeloincremental in libpomelo.hpp. pomelo_incremental_error is NULL if the last call
+   succeeded, a failed move changes nothing. The object has to be released with pomelo_incremental_free */
+typedef struct pomelo_incremental pomelo_incremental;
+
+pomelo_incremental* pomelo_incremental_create(size_t n, const double* xyz, const int* labels, const pomelo_box* box);
+int pomelo_incremental_move(pomelo_incremental* d, int label, size_t n, const double* xyz);     /* 0 on success */
+int pomelo_incremental_translate(pomelo_incremental* d, int label, double dx, double dy, double dz);
+double pomelo_incremental_volume(const pomelo_incremental* d, int label);
+pomelo_result* pomelo_incremental_result(const pomelo_incremental* d);
+const char* pomelo_incremental_error(const pomelo_incremental* d);
+void pomelo_incremental_free(pomelo_incremental* d);
+
+/* point location, see pomelolocator in libpomelo.hpp. pomelo_locator_error is NULL if the locator has been created,
+   the object has to be released with pomelo_locator_free */
+typedef struct pomelo_locator pomelo_locator;
+
+pomelo_locator* pomelo_locator_create(size_t n, const double* xyz, const int* labels, const pomelo_box* box);
+/* labels of m probe points with x y z in probes[3*i] ..., written to result. 0 threads uses all cores, 0 on success */
+int pomelo_locate(const pomelo_locator* l, size_t m, const double* probes, int* result, unsigned int threads);
+const char* pomelo_locator_error(const pomelo_locator* l);
+void pomelo_locator_free(pomelo_locator* l);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
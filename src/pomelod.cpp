@@ -0,0 +1,270 @@
+/* 
+Copyright 2016 Simon Weis and Philipp Schoenhoefer
+
+This file is part of Pomelo.
+
+Pomelo is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Pomelo is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Pomelo.  If not, see <http://www.gnu.org/licenses/>.
+
+The development of Pomelo took place at the Friedrich-Alexander University of Erlangen and was funded by the German Research Foundation (DFG) Forschergruppe FOR1548 "Geometry and Physics of Spatial Random Systems" (GPSRS). 
+*/
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <csignal>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "libpomelo.hpp"
+#include "pomelod.h"
+
+// pomelo daemon: keeps worker threads with warm workspaces (see libpomelo.hpp) listening on a Unix domain socket, so
+// scripts with many small configurations do not pay the start of a pomelo process per configuration.
+// The wire format is described in pomelod.h
+
+namespace
+{
+    std::string socketpath = "/tmp/pomelo.sock";
+
+    void shutdown(int)
+    {
+        unlink(socketpath.c_str());
+        _exit(0);
+    }
+
+    bool readall(int fd, void* data, size_t size)
+    {
+        char* p = static_cast<char*>(data);
+        while (size > 0)
+        {
+            ssize_t r = read(fd, p, size);
+            if (r < 0 && errno == EINTR) continue;
+            if (r <= 0) return false;
+            p += r;
+            size -= r;
+        }
+        return true;
+    }
+
+    bool writeall(int fd, void const* data, size_t size)
+    {
+        char const* p = static_cast<char const*>(data);
+        while (size > 0)
+        {
+            ssize_t r = write(fd, p, size);
+            if (r < 0 && errno == EINTR) continue;
+            if (r <= 0) return false;
+            p += r;
+            size -= r;
+        }
+        return true;
+    }
+
+    template <typename T> bool readvector(int fd, std::vector<T>& v, size_t n)
+    {
+        v.resize(n);
+        return readall(fd, v.data(), n*sizeof(T));
+    }
+
+    template <typename T> bool writevector(int fd, std::vector<T> const& v)
+    {
+        return writeall(fd, v.data(), v.size()*sizeof(T));
+    }
+
+    // copy with the integer width of the wire format
+    template <typename T, typename U> std::vector<T> const& convert(std::vector<U> const& in, std::vector<T>& out)
+    {
+        out.assign(in.begin(), in.end());
+        return out;
+    }
+
+    // buffers of one worker, kept between requests
+    struct worker
+    {
+        pomeloworkspace workspace;
+        pomeloresult result;
+        std::vector<double> coordinates;
+        std::vector<double> radii;
+        std::vector<int32_t> labels32;
+        std::vector<int> labels;
+        std::vector<uint64_t> wide;
+        std::vector<uint32_t> narrow;
+
+        // false if the connection is broken and has to be closed
+        bool answer(int fd, pomelod_request const& q)
+        {
+            pomelod_response a;
+            std::memset(&a, 0, sizeof(a));
+            a.magic = POMELOD_MAGIC;
+            std::string error;
+            try
+            {
+                calculate(fd, q);
+            }
+            catch (std::string const& e)
+            {
+                error = e;
+            }
+            catch (std::exception const& e)
+            {
+                error = std::string("pomelod: ") + e.what();
+            }
+
+            if (!error.empty()) return fail(fd, error);
+            a.labels = result.volume.size();
+            a.neighbors = result.neighbor.size();
+            a.vertices = result.vertex.size()/3;
+            a.faces = result.facelabel.size();
+            a.faceindices = result.faceindex.size();
+            return writeall(fd, &a, sizeof(a))
+                && writevector(fd, result.volume)
+                && writevector(fd, convert(result.neighboroffset, wide))
+                && writevector(fd, convert(result.neighbor, narrow))
+                && writevector(fd, result.facearea)
+                && writevector(fd, result.vertex)
+                && writevector(fd, convert(result.faceoffset, wide))
+                && writevector(fd, convert(result.faceindex, wide))
+                && writevector(fd, convert(result.facelabel, narrow));
+        };
+
+        static bool fail(int fd, std::string const& error)
+        {
+            pomelod_response a;
+            std::memset(&a, 0, sizeof(a));
+            a.magic = POMELOD_MAGIC;
+            a.status = 1;
+            a.errorlength = error.size();
+            return writeall(fd, &a, sizeof(a)) && writeall(fd, error.data(), error.size());
+        };
+
+        // read the arrays of the request and run it
+        void calculate(int fd, pomelod_request const& q)
+        {
+            size_t n = q.n;
+            unsigned int dimension = (q.kind == POMELOD_PLANAR) ? 2 : 3;
+            if (!readvector(fd, coordinates, dimension*n)) throw std::string("pomelod: connection lost");
+            if (q.kind == POMELOD_SPHERES)
+            {
+                if (!readvector(fd, radii, n)) throw std::string("pomelod: connection lost");
+            }
+            else
+            {
+                if (!readvector(fd, labels32, n)) throw std::string("pomelod: connection lost");
+                labels.assign(labels32.begin(), labels32.end());
+            }
+
+            pomelobox box{q.box[0], q.box[1], q.box[2], q.box[3], q.box[4], q.box[5], (q.pbc & 1) != 0, (q.pbc & 2) != 0, (q.pbc & 4) != 0};
+            pomelooptions options;
+            if (q.epsilon > 0) options.epsilon = q.epsilon;
+            options.mesh = (q.flags & POMELOD_MESH) != 0;
+            if (q.kind == POMELOD_POINTS) pomelocalculate(coordinates, labels, box, options, result, &workspace);
+            else if (q.kind == POMELOD_SPHERES) pomelospheres(coordinates, radii, q.spacing, q.shrink, box, options, result, &workspace);
+            else pomelocalculate2d(coordinates, labels, box, options, result, &workspace);
+        };
+
+        // serve one connection until the client closes it
+        void serve(int fd)
+        {
+            pomelod_request q;
+            while (readall(fd, &q, sizeof(q)))
+            {
+                // the length of the arrays is unknown for broken headers, the connection is closed after the answer
+                if (q.magic != POMELOD_MAGIC)
+                {
+                    fail(fd, "pomelod: wrong magic number");
+                    break;
+                }
+                if (q.kind != POMELOD_POINTS && q.kind != POMELOD_SPHERES && q.kind != POMELOD_PLANAR)
+                {
+                    fail(fd, "pomelod: unknown request kind");
+                    break;
+                }
+                if (q.n > (1ull << 32))
+                {
+                    fail(fd, "pomelod: too many points in one request");
+                    break;
+                }
+                if (!answer(fd, q)) break;
+            }
+            close(fd);
+        };
+    };
+}
+
+int main (int argc, char* argv[])
+{
+    unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string a = argv[i];
+        if ((a == "-socket" || a == "--socket") && i + 1 < argc) socketpath = argv[++i];
+        else if ((a == "-threads" || a == "--threads") && i + 1 < argc) threads = std::max(1, std::atoi(argv[++i]));
+        else
+        {
+            std::cerr << "Use pomelod this way:\n\t./pomelod (-socket [path]) (-threads [n])" << std::endl;
+            std::cerr << "\tthe socket defaults to /tmp/pomelo.sock and the number of threads to the number of cores" << std::endl;
+            return -1;
+        }
+    }
+
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socketpath.size() >= sizeof(address.sun_path))
+    {
+        std::cerr << "pomelod: socket path too long" << std::endl;
+        return -1;
+    }
+    std::strcpy(address.sun_path, socketpath.c_str());
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(socketpath.c_str());
+    if (listener < 0 || bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 64) != 0)
+    {
+        std::cerr << "pomelod: cannot listen on " << socketpath << ": " << std::strerror(errno) << std::endl;
+        return -1;
+    }
+    std::signal(SIGPIPE, SIG_IGN);
+    std::signal(SIGINT, shutdown);
+    std::signal(SIGTERM, shutdown);
+    std::cout << "pomelod listening on " << socketpath << " with " << threads << " threads" << std::endl;
+
+    // every thread accepts and serves its own connections with its own workspace
+    std::vector<std::thread> workers;
+    for (unsigned int t = 0; t != threads; ++t)
+    {
+        workers.push_back(std::thread([listener]()
+        {
+            worker w;
+            while (true)
+            {
+                int fd = accept(listener, nullptr, nullptr);
+                if (fd < 0)
+                {
+                    if (errno == EINTR || errno == ECONNABORTED) continue;
+                    std::cerr << "pomelod: accept failed: " << std::strerror(errno) << std::endl;
+                    return;
+                }
+                w.serve(fd);
+            }
+        }));
+    }
+    for (std::thread& t : workers) t.join();
+    unlink(socketpath.c_str());
+    return -1;
+}
@@ -0,0 +1,69 @@
+/* 
+Copyright 2016 Simon Weis and Philipp Schoenhoefer
+
+This file is part of Pomelo.
+
+Pomelo is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Pomelo is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Pomelo.  If not, see <http://www.gnu.org/licenses/>.
+
+The development of Pomelo took place at the Friedrich-Alexander University of Erlangen and was funded by the German Research Foundation (DFG) Forschergruppe FOR1548 "Geometry and Physics of Spatial Random Systems" (GPSRS). 
+*/
+#ifndef POMELOD_H_GUARD_123456
+#define POMELOD_H_GUARD_123456
+
+#include <stdint.h>
+
+/* wire format of the pomelo daemon (pomelod). Clients connect to its Unix domain socket and send any number of
+   requests over one connection, each one is answered before the next is read. All numbers are in the byte order of
+   the machine, the structs have no padding */
+
+#define POMELOD_MAGIC 0x4f4c4d50u    /* "PMLO" */
+
+/* request kinds */
+#define POMELOD_POINTS  1u   /* n surface points: 3n double x y z, n int32 labels */
+#define POMELOD_SPHERES 2u   /* n spheres (sphere i gets label i): 3n double x y z, n double radii */
+#define POMELOD_PLANAR  3u   /* n points in the plane: 2n double x y, n int32 labels */
+
+/* request flags */
+#define POMELOD_MESH 1u      /* return the vertices and faces of the merged cells */
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t kind;
+    uint32_t flags;
+    uint32_t pbc;           /* bit 0: x, bit 1: y, bit 2: z periodic */
+    uint64_t n;
+    double box[6];          /* xmin xmax ymin ymax zmin zmax */
+    double epsilon;         /* POINTS and SPHERES: surface points closer than this are merged, 0 for the default */
+    double spacing;         /* SPHERES: point spacing on the surfaces */
+    double shrink;          /* SPHERES: the radii are reduced by shrink */
+} pomelod_request;
+
+/* the answer is followed by the arrays of libpomelo.hpp in this order, status 0 means success:
+   double volume[labels], uint64 neighboroffset[labels + 1], uint32 neighbor[neighbors], double facearea[neighbors],
+   double vertex[3*vertices], uint64 faceoffset[faces + 1], uint64 faceindex[faceindices], uint32 facelabel[faces].
+   On errors all counts are 0 and only the message of errorlength characters follows */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t status;
+    uint64_t labels;
+    uint64_t neighbors;
+    uint64_t vertices;
+    uint64_t faces;
+    uint64_t faceindices;
+    uint64_t errorlength;
+} pomelod_response;
+
+#endif
@@ -0,0 +1,357 @@
+/* 
+Copyright 2016 Simon Weis and Philipp Schoenhoefer
+
+This file is part of Pomelo.
+
+Pomelo is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Pomelo is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Pomelo.  If not, see <http://www.gnu.org/licenses/>.
+
+The development of Pomelo took place at the Friedrich-Alexander University of Erlangen and was funded by the German Research Foundation (DFG) Forschergruppe FOR1548 "Geometry and Physics of Spatial Random Systems" (GPSRS). 
+*/
+#ifndef QUADRATURESPHERES_H_GUARD_123456
+#define QUADRATURESPHERES_H_GUARD_123456
+
+#include <vector>
+#include <map>
+#include <cmath>
+#include <limits>
+#include <array>
+#include <algorithm>
+#include <iostream>
+#include "include.hpp"
+#include "pointpattern.hpp"
+#include "writerpoly.hpp"
+#include "triangle.hpp"
+#include "vec3.hpp"
+#include "spheresampling.hpp"
+
+// set voronoi diagram of spheres by quadrature instead of a surface triangulation
+// the face between sphere i and sphere j is the hyperboloid sheet |x-ci| - ri = |x-cj| - rj. Along the direction u from ci
+// it is hit at t = (|d|^2 - delta^2) / (2 (u.d + delta)) with d = cj - ci and delta = rj - ri (only if the denominator is positive),
+// so the distance from the center to the cell boundary is the smallest t of all neighbors in every direction.
+// volumes and face areas are integrals of this distance over the unit sphere, evaluated with a Fibonacci lattice of directions.
+// error model: the integrand is smooth inside every face and has kinks at the edges, so the error decreases with the number
+// of directions, but a face is only seen if one of the directions hits it. A face whose solid angle seen from the center is
+// smaller than the spacing of the directions (about 4 pi / directions) can be missed, its neighbor is then absent from the
+// face list and its area is counted for the adjacent faces.
+// candidates: a point x of the cell of sphere i is not closer to any other surface, so the ball around x with radius |x-ci| - ri
+// is empty and |x-ci| <= ri + hole, where hole bounds the radius of the largest empty ball. A point on the face to j has the
+// same bound |x-cj| <= rj + hole, so only images with |d| <= ri + rj + 2 hole can share a face with sphere i. They are found
+// with a cell list, including the images of the sphere itself in periodic boxes.
+class quadraturespheres
+{
+public:
+    unsigned int directions;    // number of quadrature directions per particle
+    unsigned int meshdepth;     // subdivisions of an octahedron for the mesh output, no mesh for 0
+    int nx, ny, nz;             // subdivision of the voro++ container
+    double hole;                // upper bound of the radius of the largest empty ball
+
+    std::vector<double> volume;                             // by particle label
+    std::vector<std::map<unsigned int, double> > facearea; // by particle label, area of the face to every neighbor label
+
+    quadraturespheres (unsigned int n, unsigned int d) : directions(n), meshdepth(d), nx(0), ny(0), nz(0), hole(0)
+    {};
+
+    void calculate(pointpattern const& centers, std::vector<double> const& radii, double xmin, double xmax, double ymin, double ymax, double zmin, double zmax, bool xpbc, bool ypbc, bool zpbc, writerpoly& pw)
+    {
+        using namespace voro;
+        if (radii.size() != centers.points.size())
+        {
+            throw std::string("quadrature spheres: number of radii does not match the number of particles");
+        }
+        box = {{xmin, xmax, ymin, ymax, zmin, zmax}};
+        pbc = {{xpbc, ypbc, zpbc}};
+
+        unsigned int maxlabel = 0;
+        double rmax = 0;
+        for (unsigned long id = 0; id != centers.points.size(); ++id)
+        {
+            if (static_cast<unsigned int>(centers.points[id].l) > maxlabel) maxlabel = centers.points[id].l;
+            rmax = std::max(rmax, radii[id]);
+        }
+        volume.assign(maxlabel+1, 0);
+        facearea.assign(maxlabel+1, std::map<unsigned int, double>());
+        if (centers.points.empty()) return;
+
+        // the radical tessellation gives a nearby sphere for every point of the box
+        {
+            pre_container_poly pcon(xmin, xmax, ymin, ymax, zmin, zmax, xpbc, ypbc, zpbc);
+            for (unsigned long id = 0; id != centers.points.size(); ++id)
+            {
+                point const& p = centers.points[id];
+                pcon.put(id, p.x, p.y, p.z, radii[id]);
+            }
+            pcon.guess_optimal(nx, ny, nz);
+            container_poly con(xmin, xmax, ymin, ymax, zmin, zmax, nx, ny, nz, xpbc, ypbc, zpbc, 8);
+            pcon.setup(con);
+            hole = holebound(con, centers, radii);
+        }
+        std::cout << "largest empty ball has a radius below " << hole << std::endl;
+
+        std::vector<std::vector<neighbor> > candidates = neighborlist(centers, radii, 2.0*rmax + 2.0*hole);
+
+        std::vector<vec3> quadrature = fibonaccisphere(directions);
+        double weight = 4.0*M_PI/static_cast<double>(directions);
+
+        trianglemesh mesh;
+        if (meshdepth > 0) mesh = octahedron(meshdepth);
+
+        unsigned long long candidatecount = 0;
+        for (unsigned long i = 0; i != centers.points.size(); ++i)
+        {
+            std::vector<neighbor> const& nb = candidates[i];
+            candidatecount += nb.size();
+            vec3 ci = tovec3(centers.points[i]);
+
+            unsigned int l = centers.points[i].l;
+            for (vec3 const& u : quadrature)
+            {
+                int owner = -1;
+                double t = boundary(ci, u, nb, owner);
+                volume[l] += weight*t*t*t/3.0;
+                if (owner < 0) continue;
+                // faces to the images of the sphere itself are inside the set voronoi cell of the particle
+                if (nb[owner].id == static_cast<int>(i)) continue;
+
+                // area element of the sheet: t^2 dOmega / cos(angle between u and the sheet normal)
+                neighbor const& n = nb[owner];
+                vec3 x = u*t;
+                vec3 toj = x - n.d;
+                vec3 normal = u - normalize(toj);
+                double c = std::fabs(dot(u, normal))/normal.length();
+                if (c > 0) facearea[l][centers.points[n.id].l] += weight*t*t/c;
+            }
+
+            if (meshdepth == 0) continue;
+            std::vector<vec3> vertices;
+            vertices.reserve(mesh.vertices.size());
+            for (vec3 const& u : mesh.vertices)
+            {
+                int owner = -1;
+                vertices.push_back(ci + u*boundary(ci, u, nb, owner));
+            }
+            for (auto const& tri : mesh.triangles)
+            {
+                std::vector<double> positionlist;
+                for (unsigned int k : tri)
+                {
+                    positionlist.push_back(vertices[k].x);
+                    positionlist.push_back(vertices[k].y);
+                    positionlist.push_back(vertices[k].z);
+                }
+                pw.addface(positionlist, l);
+            }
+        }
+        std::cout << "calculated " << centers.points.size() << " cells with " << directions << " directions and " << static_cast<double>(candidatecount)/centers.points.size() << " candidate neighbors each" << std::endl;
+    };
+
+private:
+    struct neighbor
+    {
+        int id;
+        vec3 d;             // center distance vector to this image
+        double delta;       // difference of the radii
+        double numerator;   // |d|^2 - delta^2
+    };
+
+    std::array<double, 6> box;
+    std::array<bool, 3> pbc;
+
+    // the distance to the nearest surface D(y) = min_j |y-cj| - rj is 1-Lipschitz and below |y-cp| - rp for every sphere p.
+    // Its maximum over the box is the radius of the largest empty ball, bounded by the maximum of |y-cp| - rp on a grid,
+    // with p the radical cell containing the grid point y, plus half the diagonal of a grid cell
+    double holebound(voro::container_poly& con, pointpattern const& centers, std::vector<double> const& radii) const
+    {
+        double l[3] = {box[1] - box[0], box[3] - box[2], box[5] - box[4]};
+        double spacing = std::cbrt(l[0]*l[1]*l[2]/(64.0*centers.points.size()));
+        unsigned int n[3];
+        double g[3];
+        for (unsigned int a = 0; a != 3; ++a)
+        {
+            n[a] = std::max(1u, static_cast<unsigned int>(std::ceil(l[a]/spacing)));
+            g[a] = l[a]/n[a];
+        }
+
+        double dmax = -std::numeric_limits<double>::max();
+        for (unsigned int gx = 0; gx != n[0]; ++gx)
+        for (unsigned int gy = 0; gy != n[1]; ++gy)
+        for (unsigned int gz = 0; gz != n[2]; ++gz)
+        {
+            vec3 y{box[0] + (gx + 0.5)*g[0], box[2] + (gy + 0.5)*g[1], box[4] + (gz + 0.5)*g[2]};
+            double rx, ry, rz;
+            int pid;
+            double d = std::numeric_limits<double>::max();
+            if (con.find_voronoi_cell(y.x, y.y, y.z, rx, ry, rz, pid))
+            {
+                d = minimumimage(tovec3(centers.points[pid]) - y).length() - radii[pid];
+            }
+            else
+            {
+                for (unsigned long id = 0; id != centers.points.size(); ++id)
+                {
+                    d = std::min(d, minimumimage(tovec3(centers.points[id]) - y).length() - radii[id]);
+                }
+            }
+            dmax = std::max(dmax, d);
+        }
+        return std::max(0.0, dmax + 0.5*std::sqrt(g[0]*g[0] + g[1]*g[1] + g[2]*g[2]));
+    };
+
+    // all images j of all spheres with |d| <= ri + rj + (cutoff - 2 rmax), from a cell list with bins of at least the cutoff
+    std::vector<std::vector<neighbor> > neighborlist(pointpattern const& centers, std::vector<double> const& radii, double cutoff) const
+    {
+        double rmax = 0;
+        for (double r : radii) rmax = std::max(rmax, r);
+        double slack = cutoff - 2.0*rmax;
+
+        double lo[3] = {box[0], box[2], box[4]};
+        double l[3] = {box[1] - box[0], box[3] - box[2], box[5] - box[4]};
+        int nb[3];
+        int reach[3];
+        for (unsigned int a = 0; a != 3; ++a)
+        {
+            nb[a] = std::max(1, std::min(256, static_cast<int>(l[a]/cutoff)));
+            reach[a] = static_cast<int>(std::ceil(cutoff/(l[a]/nb[a])));
+            if (!pbc[a]) reach[a] = std::min(reach[a], nb[a] - 1);
+        }
+
+        // positions wrapped into the box and their bins
+        std::vector<vec3> wrapped(centers.points.size());
+        std::vector<std::array<int, 3> > bin(centers.points.size());
+        std::vector<std::vector<unsigned long> > bins(nb[0]*nb[1]*nb[2]);
+        for (unsigned long id = 0; id != centers.points.size(); ++id)
+        {
+            double c[3] = {centers.points[id].x, centers.points[id].y, centers.points[id].z};
+            for (unsigned int a = 0; a != 3; ++a)
+            {
+                if (pbc[a]) c[a] -= l[a]*std::floor((c[a] - lo[a])/l[a]);
+                bin[id][a] = std::max(0, std::min(nb[a] - 1, static_cast<int>(std::floor((c[a] - lo[a])/l[a]*nb[a]))));
+            }
+            wrapped[id] = vec3{c[0], c[1], c[2]};
+            bins[(bin[id][0]*nb[1] + bin[id][1])*nb[2] + bin[id][2]].push_back(id);
+        }
+
+        std::vector<std::vector<neighbor> > list(centers.points.size());
+        for (unsigned long i = 0; i != centers.points.size(); ++i)
+        {
+            for (int ox = -reach[0]; ox <= reach[0]; ++ox)
+            for (int oy = -reach[1]; oy <= reach[1]; ++oy)
+            for (int oz = -reach[2]; oz <= reach[2]; ++oz)
+            {
+                int o[3] = {ox, oy, oz};
+                int b[3];
+                double shift[3];
+                bool inside = true;
+                for (unsigned int a = 0; a != 3; ++a)
+                {
+                    b[a] = bin[i][a] + o[a];
+                    int s = (b[a] >= 0) ? b[a]/nb[a] : -((-b[a] + nb[a] - 1)/nb[a]);
+                    if (s != 0 && !pbc[a]) inside = false;
+                    b[a] -= s*nb[a];
+                    shift[a] = s*l[a];
+                }
+                if (!inside) continue;
+                bool shifted = (shift[0] != 0 || shift[1] != 0 || shift[2] != 0);
+                for (unsigned long j : bins[(b[0]*nb[1] + b[1])*nb[2] + b[2]])
+                {
+                    if (j == i && !shifted) continue;
+                    neighbor n;
+                    n.id = j;
+                    n.d = wrapped[j] + vec3{shift[0], shift[1], shift[2]} - wrapped[i];
+                    n.delta = radii[j] - radii[i];
+                    double distance = n.d.length();
+                    if (distance > radii[i] + radii[j] + slack) continue;
+                    if (j != i && distance <= std::fabs(n.delta))
+                    {
+                        std::cerr << "WARNING: sphere " << centers.points[i].l << " overlaps sphere " << centers.points[j].l << " completely, ignoring this pair" << std::endl;
+                        continue;
+                    }
+                    n.numerator = distance*distance - n.delta*n.delta;
+                    list[i].push_back(n);
+                }
+            }
+        }
+        return list;
+    };
+
+
+    vec3 minimumimage(vec3 d) const
+    {
+        double lx = box[1] - box[0];
+        double ly = box[3] - box[2];
+        double lz = box[5] - box[4];
+        if (pbc[0]) d.x -= lx*std::round(d.x/lx);
+        if (pbc[1]) d.y -= ly*std::round(d.y/ly);
+        if (pbc[2]) d.z -= lz*std::round(d.z/lz);
+        return d;
+    };
+
+    // distance from the center c to the cell boundary along u, owner is the index of the neighbor (-1 for a wall)
+    double boundary(vec3 const& c, vec3 const& u, std::vector<neighbor> const& nb, int& owner) const
+    {
+        double t = std::numeric_limits<double>::max();
+        owner = -1;
+        for (unsigned int k = 0; k != nb.size(); ++k)
+        {
+            double denominator = 2.0*(dot(u, nb[k].d) + nb[k].delta);
+            if (denominator <= 0) continue;
+            double tk = nb[k].numerator/denominator;
+            if (tk < t)
+            {
+                t = tk;
+                owner = k;
+            }
+        }
+        // walls of non periodic boxes
+        double const* lo[3] = {&box[0], &box[2], &box[4]};
+        double const* hi[3] = {&box[1], &box[3], &box[5]};
+        double uc[3] = {u.x, u.y, u.z};
+        double cc[3] = {c.x, c.y, c.z};
+        for (unsigned int a = 0; a != 3; ++a)
+        {
+            if (pbc[a] || uc[a] == 0) continue;
+            double tw = ((uc[a] > 0 ? *hi[a] : *lo[a]) - cc[a])/uc[a];
+            if (tw < t)
+            {
+                t = tw;
+                owner = -1;
+            }
+        }
+        return t;
+    };
+
+    // unit sphere triangulated by a subdivided octahedron
+    static trianglemesh octahedron(unsigned int depth)
+    {
+        trianglemesh m;
+        m.addvertex(vec3{1, 0, 0});
+        m.addvertex(vec3{-1, 0, 0});
+        m.addvertex(vec3{0, 1, 0});
+        m.addvertex(vec3{0, -1, 0});
+        m.addvertex(vec3{0, 0, 1});
+        m.addvertex(vec3{0, 0, -1});
+        m.addtriangle(0, 2, 4);
+        m.addtriangle(2, 1, 4);
+        m.addtriangle(1, 3, 4);
+        m.addtriangle(3, 0, 4);
+        m.addtriangle(2, 0, 5);
+        m.addtriangle(1, 2, 5);
+        m.addtriangle(3, 1, 5);
+        m.addtriangle(0, 3, 5);
+        m.subdivide(depth);
+        for (vec3& v : m.vertices) v = normalize(v);
+        return m;
+    };
+};
+
+#endif
@@ -0,0 +1,126 @@
+/* 
+Copyright 2016 Simon Weis and Philipp Schoenhoefer
+
+This file is part of Pomelo.
+
+Pomelo is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Pomelo is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Pomelo.  If not, see <http://www.gnu.org/licenses/>.
+
+The development of Pomelo took place at the Friedrich-Alexander University of Erlangen and was funded by the German Research Foundation (DFG) Forschergruppe FOR1548 "Geometry and Physics of Spatial Random Systems" (GPSRS). 
+*/
+#ifndef SELECTION_H_GUARD_123456
+#define SELECTION_H_GUARD_123456
+
+#include <string>
+#include <vector>
+#include <set>
+#include <cmath>
+#include "pointpattern.hpp"
+#include "splitstring.hpp"
+
+// particles whose set voronoi cells are calculated (-select, -region), all other particles only bound their cells.
+// A particle is selected if its label is in the list and its center lies in the region, the center is the mean of its
+// surface points (taken at the periodic image closest to its first point)
+class particleselection
+{
+public:
+    std::set<int> labels;       // empty for all labels
+    std::string region;         // "", "box" or "sphere"
+    std::vector<double> bounds; // box: xmin xmax ymin ymax zmin zmax, sphere: x y z r
+
+    bool active() const
+    {
+        return !labels.empty() || !region.empty();
+    };
+
+    // comma separated labels and ranges, e.g. "1,5,10-20"
+    void parselabels(std::string const& list)
+    {
+        splitstring s(list.c_str());
+        for (std::string const& item : s.split(','))
+        {
+            if (item.empty()) continue;
+            size_t dash = item.find('-', 1);
+            int first = std::stoi(item.substr(0, dash));
+            int last = (dash == std::string::npos) ? first : std::stoi(item.substr(dash + 1));
+            if (last < first) throw std::string("cannot parse label range " + item);
+            for (int l = first; l <= last; ++l) labels.insert(l);
+        }
+        if (labels.empty()) throw std::string("no labels selected");
+    };
+
+    // selected flag by particle label
+    std::vector<bool> select(pointpattern const& pp, double xmin, double xmax, double ymin, double ymax, double zmin, double zmax, bool xpbc, bool ypbc, bool zpbc) const
+    {
+        double length[3] = {xmax - xmin, ymax - ymin, zmax - zmin};
+        bool pbc[3] = {xpbc, ypbc, zpbc};
+
+        // first point and sum of the offsets to it by label
+        std::vector<std::vector<double> > sum;
+        for (point const& p : pp.points)
+        {
+            if (p.l < 0) continue;
+            if (sum.size() <= static_cast<size_t>(p.l)) sum.resize(p.l + 1);
+            std::vector<double>& s = sum[p.l];
+            if (s.empty()) s = {p.x, p.y, p.z, 0, 0, 0, 0};
+            double x[3] = {p.x, p.y, p.z};
+            for (int a = 0; a != 3; ++a)
+            {
+                double d = x[a] - s[a];
+                if (pbc[a]) d -= length[a]*std::round(d/length[a]);
+                s[3 + a] += d;
+            }
+            s[6] += 1;
+        }
+
+        std::vector<bool> selected(sum.size(), false);
+        for (size_t l = 0; l != sum.size(); ++l)
+        {
+            if (sum[l].empty()) continue;
+            if (!labels.empty() && labels.find(static_cast<int>(l)) == labels.end()) continue;
+            double c[3];
+            for (int a = 0; a != 3; ++a) c[a] = sum[l][a] + sum[l][3 + a]/sum[l][6];
+            selected[l] = inside(c, length, pbc);
+        }
+        return selected;
+    };
+
+private:
+    bool inside(double const* c, double const* length, bool const* pbc) const
+    {
+        if (region == "box")
+        {
+            for (int a = 0; a != 3; ++a)
+            {
+                double x = c[a];
+                // periodic images of the center are tried in the box
+                if (pbc[a]) x = bounds[2*a] + std::fmod(std::fmod(x - bounds[2*a], length[a]) + length[a], length[a]);
+                if (x < bounds[2*a] || x > bounds[2*a + 1]) return false;
+            }
+        }
+        else if (region == "sphere")
+        {
+            double d2 = 0;
+            for (int a = 0; a != 3; ++a)
+            {
+                double d = c[a] - bounds[a];
+                if (pbc[a]) d -= length[a]*std::round(d/length[a]);
+                d2 += d*d;
+            }
+            if (d2 > bounds[3]*bounds[3]) return false;
+        }
+        return true;
+    };
+};
+
+#endif
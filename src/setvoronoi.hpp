@@ -0,0 +1,341 @@
+/* 
+Copyright 2016 Simon Weis and Philipp Schoenhoefer
+
+This file is part of Pomelo.
+
+Pomelo is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Pomelo is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Pomelo.  If not, see <http://www.gnu.org/licenses/>.
+
+The development of Pomelo took place at the Friedrich-Alexander University of Erlangen and was funded by the German Research Foundation (DFG) Forschergruppe FOR1548 "Geometry and Physics of Spatial Random Systems" (GPSRS). 
+*/
+#ifndef SETVORONOI_H_GUARD_123456
+#define SETVORONOI_H_GUARD_123456
+
+#include <vector>
+#include <map>
+#include <set>
+#include <string>
+#include <iostream>
+#include <memory>
+#include <cmath>
+#include <algorithm>
+#include "include.hpp"
+#include "pointpattern.hpp"
+#include "duplicationremover.hpp"
+#include "writerpoly.hpp"
+
+// the set voronoi pipeline: voronoi diagram of the surface points and merge of the cells by particle label
+// works on the pointpattern in memory and keeps all state in the object, so several diagrams can be calculated at
+// the same time (e.g. one per thread). Nothing is written to disk
+class setvoronoi
+{
+public:
+    bool verbose;               // progress output on std::cout
+    bool mesh;                  // collect the faces of the merged cells in pw
+    bool cells;                 // record the number of faces and the volume of every unmerged cell
+    std::vector<bool> selection;    // by particle label. If not empty, only the cells of selected particles are calculated,
+                                    // the points of the other particles only bound them
+
+    std::vector<double> volume;                             // by particle label
+    std::vector<std::map<unsigned int, double> > facearea;  // by particle label, face area to every neighbor label
+    writerpoly pw;                      // faces of the merged cells, unwrapped around the first point of every particle
+    unsigned long long vertices;        // number of vertices in pw before duplicates are removed
+    std::vector<unsigned int> cellfaces;    // only with cells: by surface point, 0 for points whose cell was not calculated
+    std::vector<double> cellvolume;
+    int nx, ny, nz;                     // division of the voro++ container
+    bool triclinic;     // periodic parallelepiped with the edges (lx, 0, 0), (xy, ly, 0) and (xz, yz, lz) as in LAMMPS,
+    double xy, xz, yz;  // where lx, ly, lz are the lengths of the box passed to calculate and (xmin, ymin, zmin) its corner
+
+    setvoronoi () : verbose(true), mesh(true), cells(false), vertices(0), nx(0), ny(0), nz(0), triclinic(false), xy(0), xz(0), yz(0)
+    {};
+
+    // remove points that are closer than epsilon, the pointpattern is changed in place
+    void removeduplicates(pointpattern& pp, double epsilon, double xmin, double xmax, double ymin, double ymax, double zmin, double zmax) const
+    {
+        if (verbose) std::cout << "remove duplicates in surface triangulation" << std::endl;
+        duplicationremover d(40,40,40);
+        d.verbose = verbose;
+        d.setboundaries(xmin, xmax, ymin, ymax, zmin, zmax);
+        d.addPoints(pp);
+        d.removeduplicates(epsilon);
+        d.getallPoints(pp);
+    };
+
+    void calculate(pointpattern const& pp, double xmin, double xmax, double ymin, double ymax, double zmin, double zmax, bool xpbc, bool ypbc, bool zpbc)
+    {
+        using namespace voro;
+        volume.clear();
+        facearea.clear();
+        pw = writerpoly();
+        vertices = 0;
+        cellfaces.assign(cells ? pp.points.size() : 0, 0);
+        cellvolume.assign(cells ? pp.points.size() : 0, 0);
+        if (triclinic && !(xpbc && ypbc && zpbc)) throw std::string("a triclinic box has to be periodic in all directions");
+
+        // label of every surface point and the first point of every particle, the cells are unwrapped around it
+        std::vector<int> label(pp.points.size());
+        std::vector<std::vector<double> > ref;
+        unsigned int maxParticleLabel = 0;
+        for (unsigned long long id = 0; id != pp.points.size(); ++id)
+        {
+            point const& p = pp.points[id];
+            if (p.l < 0) throw std::string("negative particle label");
+            unsigned int l = p.l;
+            label[id] = p.l;
+            if (l > maxParticleLabel) maxParticleLabel = l;
+            if(ref.size() < l+1) ref.resize(l+1);
+            if(ref[l].empty())
+            {
+                ref[l] = {p.x, p.y, p.z, 0, 0, 0};
+            }
+        }
+        volume.resize(maxParticleLabel+1, 0);
+        facearea.resize(maxParticleLabel+1);
+        box = {xmin, ymin, zmin, xmax - xmin, ymax - ymin, zmax - zmin};
+        pbc = {xpbc, ypbc, zpbc};
+
+        if (triclinic)
+        {
+            calculatetriclinic(pp, label, ref);
+            return;
+        }
+
+        // add particle surface triangulation to voro++ pre container for subcell division estimate
+        if (verbose) std::cout << "importing surface triangulation to voro++" << std::endl;
+        pre_container pcon(xmin, xmax, ymin, ymax, zmin, zmax, xpbc, ypbc, zpbc);
+        for (unsigned long long id = 0; id != pp.points.size(); ++id)
+        {
+            point const& p = pp.points[id];
+            pcon.put(id, p.x, p.y, p.z);
+        }
+        unsigned long long numberofpoints = pp.points.size();
+
+        // setting up voro++ container, the one of the last call is cleared and reused if the geometry is the same
+        pcon.guess_optimal(nx,ny,nz);
+        std::vector<double> geometry = {xmin, xmax, ymin, ymax, zmin, zmax, double(nx), double(ny), double(nz), double(xpbc), double(ypbc), double(zpbc)};
+        if (!reusedcontainer || geometry != reusedgeometry)
+        {
+            reusedcontainer.reset(new container(xmin, xmax, ymin, ymax, zmin, zmax, nx, ny, nz, xpbc, ypbc, zpbc, 8));
+            reusedgeometry = geometry;
+        }
+        container& con = *reusedcontainer;
+        // the selected points are recorded in the order in which their cells are calculated
+        particle_order selectedorder;
+        bool selecting = !selection.empty();
+        if (selecting)
+        {
+            numberofpoints = 0;
+            for (unsigned long long id = 0; id != pp.points.size(); ++id)
+            {
+                point const& p = pp.points[id];
+                if (static_cast<size_t>(p.l) < selection.size() && selection[p.l])
+                {
+                    con.put(selectedorder, id, p.x, p.y, p.z);
+                    ++numberofpoints;
+                }
+                else
+                {
+                    con.put(id, p.x, p.y, p.z);
+                }
+            }
+        }
+        else
+        {
+            pcon.setup(con);
+        }
+        if (verbose) std::cout << "setting up voro++ container with division: (" << nx << " " << ny << " " << nz << ") for N= " << pp.points.size() << " particles " << std::endl << std::endl;
+
+        c_loop_all all(con);
+        c_loop_order selected(con, selectedorder);
+
+        if (verbose && selecting) std::cout << "calculating the cells of " << numberofpoints << " points of the selected particles" << std::endl;
+        if (selecting) merge(con, selected, label, ref, numberofpoints);
+        else merge(con, all, label, ref, numberofpoints);
+        con.clear();
+    };
+private:
+    std::unique_ptr<voro::container> reusedcontainer;
+    std::vector<double> reusedgeometry;
+    std::vector<double> box;    // corner and lengths of the box of the current calculation
+    std::vector<bool> pbc;
+
+    // the same with voro++'s container_periodic, which stores the points in the sheared unit cell with its corner at the
+    // origin and creates the periodic images it needs on the fly
+    void calculatetriclinic(pointpattern const& pp, std::vector<int> const& label, std::vector<std::vector<double> >& ref)
+    {
+        using namespace voro;
+        if (verbose) std::cout << "importing surface triangulation to voro++ (triclinic box, tilt " << xy << " " << xz << " " << yz << ")" << std::endl;
+
+        // about optimal_particles points per block, as guess_optimal of the pre_container
+        double const n = static_cast<double>(pp.points.size());
+        double const scale = std::cbrt(n/(optimal_particles*box[3]*box[4]*box[5]));
+        nx = std::max(1, static_cast<int>(box[3]*scale + 1));
+        ny = std::max(1, static_cast<int>(box[4]*scale + 1));
+        nz = std::max(1, static_cast<int>(box[5]*scale + 1));
+        // not reused: clear() of container_periodic keeps the periodic images of the last call
+        container_periodic con(box[3], xy, box[4], xz, yz, box[5], nx, ny, nz, 8);
+
+        particle_order selectedorder;
+        bool selecting = !selection.empty();
+        unsigned long long numberofpoints = 0;
+        for (unsigned long long id = 0; id != pp.points.size(); ++id)
+        {
+            point const& p = pp.points[id];
+            bool chosen = !selecting || (static_cast<size_t>(p.l) < selection.size() && selection[p.l]);
+            if (selecting && chosen) con.put(selectedorder, id, p.x - box[0], p.y - box[1], p.z - box[2]);
+            else con.put(id, p.x - box[0], p.y - box[1], p.z - box[2]);
+            if (chosen) ++numberofpoints;
+        }
+        if (verbose) std::cout << "setting up voro++ periodic container with division: (" << nx << " " << ny << " " << nz << ") for N= " << pp.points.size() << " particles " << std::endl << std::endl;
+
+        c_loop_all_periodic all(con);
+        c_loop_order_periodic selected(con, selectedorder);
+
+        if (verbose && selecting) std::cout << "calculating the cells of " << numberofpoints << " points of the selected particles" << std::endl;
+        if (selecting) merge(con, selected, label, ref, numberofpoints);
+        else merge(con, all, label, ref, numberofpoints);
+    };
+
+    // merge voronoi cells to set voronoi diagram: sum up the volumes and the face areas between different particles and
+    // collect the faces between them, unwrapped around the first point of every particle
+    template<class c_class, class c_loop>
+    void merge(c_class& con, c_loop& cla, std::vector<int> const& label, std::vector<std::vector<double> >& ref, unsigned long long numberofpoints)
+    {
+        using namespace voro;
+        if (verbose) std::cout << "merge voronoi cells ";
+        // cell currently worked on
+        unsigned long long status = 0;
+        // counter for process output
+        double tenpercentSteps = 0.01*static_cast<double>(numberofpoints);
+        double target = tenpercentSteps;
+
+        // the periodic container works relative to the corner of the box
+        double const ox = triclinic ? box[0] : 0;
+        double const oy = triclinic ? box[1] : 0;
+        double const oz = triclinic ? box[2] : 0;
+
+        if(cla.start())
+        {
+            if (verbose) std::cout << "started\n" << std::flush;
+            voronoicell_neighbor c;
+            do
+            {
+                status++;
+                if(!con.compute_cell(c,cla)) continue;
+                if (verbose && status >= target)
+                {
+                    target += tenpercentSteps;
+                    std::cout << static_cast<int>(static_cast<double>(status)/static_cast<double>(numberofpoints)*100) << " \% " << std::flush;
+                }
+                // Get the position of the current particle under consideration
+                double xc = 0;
+                double yc = 0;
+                double zc = 0;
+                cla.pos(xc,yc,zc);
+                xc += ox;
+                yc += oy;
+                zc += oz;
+
+                unsigned int l = label[cla.pid()];
+                double cv = c.volume();
+                volume[l] += cv;
+                if (cells)
+                {
+                    cellfaces[cla.pid()] = c.number_of_faces();
+                    cellvolume[cla.pid()] = cv;
+                }
+
+                // periodic image of the cell that is closest to the first point of the particle
+                shift(xc - ref[l][0], yc - ref[l][1], zc - ref[l][2], ref[l]);
+
+                std::vector<int> w; // neighbors of faces
+                c.neighbors(w);
+                std::vector<double> a;
+                c.face_areas(a);
+
+                std::vector<int> f; // list of face vertices (bracketed, as ID)
+                std::vector<double> cellvertices;   // all vertices for this cell
+                if (mesh)
+                {
+                    c.face_vertices(f);
+                    c.vertices(xc,yc,zc, cellvertices);
+                }
+
+                // for this cell, loop over all faces and keep the ones between different particles. Negative ids are walls
+                unsigned long long index = 0;
+                for (unsigned long long k = 0; k != w.size(); ++k)
+                {
+                    int n = w[k];   // ID of neighbor cell
+                    unsigned long long first = index + 1;
+                    if (mesh) index += f[index] + 1;
+                    if (n >= 0 && label[n] == static_cast<int>(l)) continue;
+                    if (n >= 0) facearea[l][label[n]] += a[k];
+                    if (!mesh) continue;
+
+                    std::vector<double> positionlist;
+                    for (unsigned long long i = first; i != index; ++i)
+                    {
+                        unsigned int vertexindex = f[i];
+                        double x = cellvertices[vertexindex*3];
+                        double y = cellvertices[vertexindex*3+1];
+                        double z = cellvertices[vertexindex*3+2];
+
+                        if(pbc[0]) x += ref[l][3];
+                        if(pbc[1]) y += ref[l][4];
+                        if(pbc[2]) z += ref[l][5];
+
+                        positionlist.push_back(x);
+                        positionlist.push_back(y);
+                        positionlist.push_back(z);
+                    }
+                    vertices += positionlist.size()/3;
+                    pw.addface(positionlist, l);
+                }
+            }
+            while (cla.inc());
+        }
+        if (verbose) std::cout << std::endl << " finished with N= " << vertices << std::endl << std::endl;
+    };
+
+    // shift of a cell at distance (dx, dy, dz) from the reference point to the periodic image closest to it, stored in
+    // r[3] ... r[5]. In a triclinic box the lattice vectors are removed from z to x, as in the minimum image convention
+    void shift(double dx, double dy, double dz, std::vector<double>& r) const
+    {
+        if (!triclinic)
+        {
+            r[3] = pbc[0] ? unwrap(dx, box[3]) : 0;
+            r[4] = pbc[1] ? unwrap(dy, box[4]) : 0;
+            r[5] = pbc[2] ? unwrap(dz, box[5]) : 0;
+            return;
+        }
+        double const kz = std::round(dz/box[5]);
+        double x = dx - kz*xz;
+        double y = dy - kz*yz;
+        double const ky = std::round(y/box[4]);
+        x -= ky*xy;
+        double const kx = std::round(x/box[3]);
+        r[3] = -kx*box[3] - ky*xy - kz*xz;
+        r[4] = -ky*box[4] - kz*yz;
+        r[5] = -kz*box[5];
+    };
+
+    // shift of a cell at distance d from the reference point to the periodic image closest to it
+    static double unwrap(double d, double length)
+    {
+        double alt = (d < 0) ? d + length : d - length;
+        if (d*d < alt*alt) return 0;
+        return (d < 0) ? length : -length;
+    };
+};
+
+#endif
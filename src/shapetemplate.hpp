@@ -0,0 +1,163 @@
+/* 
+Copyright 2016 Simon Weis and Philipp Schoenhoefer
+
+This file is part of Pomelo.
+
+Pomelo is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Pomelo is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Pomelo.  If not, see <http://www.gnu.org/licenses/>.
+
+The development of Pomelo took place at the Friedrich-Alexander University of Erlangen and was funded by the German Research Foundation (DFG) Forschergruppe FOR1548 "Geometry and Physics of Spatial Random Systems" (GPSRS). 
+*/
+#ifndef SHAPETEMPLATE_H_GUARD_123456
+#define SHAPETEMPLATE_H_GUARD_123456
+
+#include <vector>
+#include <map>
+#include "pointpattern.hpp"
+#include "vec3.hpp"
+
+// surface triangulation of one particle shape in its body frame (center at the origin, no rotation)
+// the coordinates are stored as separate arrays, so that the instancing loop can be vectorized
+struct shapetemplate
+{
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> z;
+
+    void addpoint(double px, double py, double pz)
+    {
+        x.push_back(px);
+        y.push_back(py);
+        z.push_back(pz);
+    };
+
+    void addpoint(vec3 const& p)
+    {
+        addpoint(p.x, p.y, p.z);
+    };
+
+    size_t size() const
+    {
+        return x.size();
+    };
+};
+
+// the parameters of one particle that define its shape (but not its position and orientation)
+// particles with the same key share one shape template
+class shapekey
+{
+public:
+    std::vector<double> values;
+    void add(double v)
+    {
+        values.push_back(v);
+    };
+};
+
+// rigid transformation from the body frame of a shape template to the position of one particle
+class rigidtransform
+{
+public:
+    rigidtransform () : r(mat3::identity()), t{0,0,0}, l(0)
+    {};
+
+    mat3 r;     // rotation matrix
+    vec3 t;     // translation, i.e. the particle center
+    int l;      // particle label
+
+    void setlabel (int cl)
+    {
+        l = cl;
+    };
+
+    void settranslation (double x, double y, double z)
+    {
+        t = vec3{x, y, z};
+    };
+
+    void setrotation (double a11, double a12, double a13, double a21, double a22, double a23, double a31, double a32, double a33)
+    {
+        r = mat3{{a11, a12, a13, a21, a22, a23, a31, a32, a33}};
+    };
+
+    // rotation matrix from a file, orthonormalized by gram-schmidt on its columns (the body axes). Rounded matrices
+    // distort the template slightly, so points that should lie on a common sphere (sphere patches of clumps or
+    // rounded edges) are only almost co-spherical, which makes voro++ fail
+    void setorthonormalrotation (double a11, double a12, double a13, double a21, double a22, double a23, double a31, double a32, double a33)
+    {
+        vec3 e1 = normalize(vec3{a11, a21, a31});
+        vec3 e2{a12, a22, a32};
+        e2 = normalize(e2 - e1*dot(e1, e2));
+        vec3 e3 = cross(e1, e2);
+        if (dot(e3, vec3{a13, a23, a33}) < 0) e3 = -e3;
+        setrotation(e1.x, e2.x, e3.x, e1.y, e2.y, e3.y, e1.z, e2.z, e3.z);
+    };
+
+    // rotate and translate all points of the template and append them to the pointpattern
+    void apply (shapetemplate const& s, pointpattern& pp) const
+    {
+        const size_t n = s.size();
+        const double* sx = s.x.data();
+        const double* sy = s.y.data();
+        const double* sz = s.z.data();
+        for(size_t i = 0; i != n; ++i)
+        {
+            vec3 q = r * vec3{sx[i], sy[i], sz[i]} + t;
+            pp.points.push_back(point(q.x, q.y, q.z, l));
+        }
+    };
+};
+
+// cache that holds one template per distinct shape key
+class shapetemplatecache
+{
+public:
+    // returns the template for this key or nullptr, if it has not been created yet
+    shapetemplate const* find (shapekey const& k) const
+    {
+        auto it = templates.find(k.values);
+        if (it == templates.end()) return nullptr;
+        return &(it->second);
+    };
+
+    shapetemplate const& insert (shapekey const& k, shapetemplate const& s)
+    {
+        return templates[k.values] = s;
+    };
+
+    // create a template from a pointpattern that has been spawned in the body frame, labels are ignored
+    shapetemplate const& insert (shapekey const& k, pointpattern const& body)
+    {
+        shapetemplate s;
+        for (auto it = body.points.begin(); it != body.points.end(); ++it)
+        {
+            s.addpoint(it->x, it->y, it->z);
+        }
+        return insert(k, s);
+    };
+
+    size_t size() const
+    {
+        return templates.size();
+    };
+
+    void clear()
+    {
+        templates.clear();
+    };
+
+private:
+    std::map<std::vector<double>, shapetemplate> templates;
+};
+
+#endif
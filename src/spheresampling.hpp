@@ -0,0 +1,52 @@
+/* 
+Copyright 2016 Simon Weis and Philipp Schoenhoefer
+
+This file is part of Pomelo.
+
+Pomelo is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Pomelo is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Pomelo.  If not, see <http://www.gnu.org/licenses/>.
+
+The development of Pomelo took place at the Friedrich-Alexander University of Erlangen and was funded by the German Research Foundation (DFG) Forschergruppe FOR1548 "Geometry and Physics of Spatial Random Systems" (GPSRS). 
+*/
+#ifndef SPHERESAMPLING_H_GUARD_123456
+#define SPHERESAMPLING_H_GUARD_123456
+
+#include <vector>
+#include <cmath>
+#include "vec3.hpp"
+
+// Fibonacci lattice with n points on the unit sphere
+// the points are spaced uniformly, there are no points at the poles and no duplicates
+inline std::vector<vec3> fibonaccisphere(unsigned int n)
+{
+    std::vector<vec3> points;
+    points.reserve(n);
+    const double goldenangle = M_PI * (3.0 - std::sqrt(5.0));
+    for (unsigned int i = 0; i != n; ++i)
+    {
+        double z = 1.0 - (2.0*i + 1.0)/n;
+        double rho = std::sqrt(1.0 - z*z);
+        double phi = goldenangle * i;
+        points.push_back(vec3{rho * std::cos(phi), rho * std::sin(phi), z});
+    }
+    return points;
+}
+
+// number of points needed to cover a surface area with a (hexagonal) point spacing
+inline unsigned int pointsforspacing(double area, double spacing)
+{
+    double n = std::ceil(area / (0.5 * std::sqrt(3.0) * spacing * spacing));
+    return (n < 1) ? 1 : static_cast<unsigned int>(n);
+}
+
+#endif
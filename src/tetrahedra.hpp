@@ -61,9 +61,10 @@ public:
             fpoints.close();
         }
 
-        centerX = (p1.x + p2.x + p3.x + p4.x)/4.0;
-        centerY = (p1.y + p2.y + p3.y + p4.y)/4.0;
-        centerZ = (p1.z + p2.z + p3.z + p4.z)/4.0;
+        vec3 center = (tovec3(p1) + tovec3(p2) + tovec3(p3) + tovec3(p4)) * 0.25;
+        centerX = center.x;
+        centerY = center.y;
+        centerZ = center.z;
 
         if(v)
         {
@@ -105,24 +106,78 @@ public:
     {
         // since they are all of the same size, just use one sidelength
 
-        double dx = p[0].x - p[1].x;
-        double dy = p[0].y - p[1].y;
-        double dz = p[0].z - p[1].z;
-
-        sidelength = std::sqrt(dx * dx + dy * dy + dz * dz);
+        sidelength = (tovec3(p[0]) - tovec3(p[1])).length();
     }
 
     bool checkPointInside( point p)
     {
-        int s1 = (a1*p.x + b1*p.y + c1*p.z + d1 > 0) ? 1 : -1;
-        int s2 = (a2*p.x + b2*p.y + c2*p.z + d2 > 0) ? 1 : -1;
+        vec3 q = tovec3(p);
+        int s1 = (dot(vec3{a1, b1, c1}, q) + d1 > 0) ? 1 : -1;
+        int s2 = (dot(vec3{a2, b2, c2}, q) + d2 > 0) ? 1 : -1;
         if (s1 != s2) return false;
-        int s3 = (a3*p.x + b3*p.y + c3*p.z + d3 > 0) ? 1 : -1;
+        int s3 = (dot(vec3{a3, b3, c3}, q) + d3 > 0) ? 1 : -1;
         if (s1 != s3) return false;
-        int s4 = (a4*p.x + b4*p.y + c4*p.z + d4 > 0) ? 1 : -1;
+        int s4 = (dot(vec3{a4, b4, c4}, q) + d4 > 0) ? 1 : -1;
 
-       return s1 == s2 == s3 == s4; 
+        return s1 == s4;
     }
 };
 
+// surface triangulation of a tetrahedron, subdivided depth times, given by the barycentric weights of the four corners
+// it is created once by subdividing the unit tetrahedron as indexed mesh, so every surface point is unique and
+// the points of a tetrahedron are just linear combinations of its corners
+class tetrahedrontemplate
+{
+public:
+    tetrahedrontemplate (unsigned int depth)
+    {
+        // unit tetrahedron, the coordinates of a point are the weights of the corners 1, 2, 3
+        // (all midpoints are dyadic fractions, so the weights are exact)
+        trianglemesh mesh;
+        mesh.addvertex(vec3{0,0,0});
+        mesh.addvertex(vec3{1,0,0});
+        mesh.addvertex(vec3{0,1,0});
+        mesh.addvertex(vec3{0,0,1});
+        mesh.addtriangle(0, 1, 2);
+        mesh.addtriangle(0, 1, 3);
+        mesh.addtriangle(0, 2, 3);
+        mesh.addtriangle(1, 2, 3);
+        mesh.subdivide(depth);
+
+        for (auto it = mesh.vertices.begin(); it != mesh.vertices.end(); ++it)
+        {
+            w0.push_back(1.0 - it->x - it->y - it->z);
+            w1.push_back(it->x);
+            w2.push_back(it->y);
+            w3.push_back(it->z);
+        }
+    };
+
+    // append the surface points of the tetrahedron with corners p[0] ... p[3] to the vector
+    void create (std::vector<point> const& p, std::vector<point>& out) const
+    {
+        vec3 p0 = tovec3(p[0]);
+        vec3 p1 = tovec3(p[1]);
+        vec3 p2 = tovec3(p[2]);
+        vec3 p3 = tovec3(p[3]);
+        int l = p[0].l;
+        for (size_t i = 0; i != size(); ++i)
+        {
+            vec3 q = p0*w0[i] + p1*w1[i] + p2*w2[i] + p3*w3[i];
+            out.push_back(point(q.x, q.y, q.z, l));
+        }
+    };
+
+    size_t size() const
+    {
+        return w0.size();
+    };
+
+private:
+    std::vector<double> w0;
+    std::vector<double> w1;
+    std::vector<double> w2;
+    std::vector<double> w3;
+};
+
 #endif
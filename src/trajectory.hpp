@@ -0,0 +1,482 @@
+/* 
+Copyright 2016 Simon Weis and Philipp Schoenhoefer
+
+This file is part of Pomelo.
+
+Pomelo is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Pomelo is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Pomelo.  If not, see <http://www.gnu.org/licenses/>.
+
+The development of Pomelo took place at the Friedrich-Alexander University of Erlangen and was funded by the German Research Foundation (DFG) Forschergruppe FOR1548 "Geometry and Physics of Spatial Random Systems" (GPSRS). 
+*/
+#ifndef TRAJECTORY_H_GUARD_123456
+#define TRAJECTORY_H_GUARD_123456
+
+#include <string>
+#include <vector>
+#include <map>
+#include <deque>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <memory>
+#include <cmath>
+#include <glob.h>
+#include "cmdlparser.hpp"
+#include "pointpattern.hpp"
+#include "parsexyz.hpp"
+#include "parsexyzr.hpp"
+#include "parseellipsoids.hpp"
+#include "parsesphcyl.hpp"
+#include "parsepolyhedra.hpp"
+#include "parsesuperquadrics.hpp"
+#include "setvoronoi.hpp"
+#include "libpomelo.hpp"
+
+// frames of a trajectory: xyz or xyzr frames (number of particles, comment line, particles) concatenated in one file
+// or spread over the files matching a pattern like "frame*.xyz", in alphabetical order. The other formats have no
+// frame header, so with wholefiles every file is read as one frame
+class trajectoryreader
+{
+public:
+    explicit trajectoryreader (std::string const& pattern, bool w = false) : wholefiles(w), file(0)
+    {
+        if (pattern.find_first_of("*?[") == std::string::npos)
+        {
+            files.push_back(pattern);
+        }
+        else
+        {
+            glob_t g;
+            if (glob(pattern.c_str(), 0, nullptr, &g) == 0)
+            {
+                for (size_t i = 0; i != g.gl_pathc; ++i) files.push_back(g.gl_pathv[i]);
+            }
+            globfree(&g);
+        }
+        if (files.empty()) throw std::string("no trajectory file matches " + pattern);
+    };
+
+    // the text of the next frame, false at the end of the trajectory
+    bool next(std::string& frame)
+    {
+        if (wholefiles)
+        {
+            if (file == files.size()) return false;
+            std::ifstream whole(files[file++]);
+            if (whole.fail()) throw std::string("cannot open trajectory file " + files[file - 1]);
+            std::ostringstream text;
+            text << whole.rdbuf();
+            frame = text.str();
+            return true;
+        }
+
+        std::string line;
+        while (true)
+        {
+            if (!infile.is_open())
+            {
+                if (file == files.size()) return false;
+                infile.open(files[file++]);
+                if (infile.fail()) throw std::string("cannot open trajectory file " + files[file - 1]);
+            }
+            if (!std::getline(infile, line))
+            {
+                infile.close();
+                infile.clear();
+                continue;
+            }
+            // empty lines between frames are skipped
+            if (line.find_first_not_of(" \t\r") != std::string::npos) break;
+        }
+
+        unsigned long n = 0;
+        try
+        {
+            n = std::stoul(line);
+        }
+        catch (...)
+        {
+            throw std::string("cannot parse the number of particles of a frame: " + line);
+        }
+        frame = line + "\n";
+        for (unsigned long i = 0; i != n + 1; ++i)
+        {
+            if (!std::getline(infile, line)) throw std::string("trajectory frame ends before all particles are read");
+            frame += line + "\n";
+        }
+        return true;
+    };
+
+private:
+    bool wholefiles;
+    std::vector<std::string> files;
+    size_t file;
+    std::ifstream infile;
+};
+
+
+// set voronoi diagrams of all frames of a trajectory (-trajectory) in one process. A reader thread parses the frames
+// ahead into a bounded queue and every worker thread keeps its parser (with the shape templates), point pattern and
+// voro++ container for the next frame. The volumes and face areas are written in frame order.
+// In the coherent mode (-coherent) a single worker moves the particles of one incremental diagram from frame to frame
+class trajectory
+{
+public:
+    bool coherent;
+    double threshold;       // particles are only moved in the coherent diagram if a surface point moved further than this
+    unsigned int refresh;   // the coherent diagram is calculated from scratch every refresh frames (0: never)
+
+    trajectory (eMode m, unsigned int t) : coherent(false), threshold(0), refresh(100), mode(m), threads(std::max(1u, t)), readerdone(false), frames(0), sincerefresh(0), recalculatedcells(0), allcells(0)
+    {};
+
+    int run(std::string const& pattern, std::string const& folder)
+    {
+        std::ofstream volumes(folder + "trajectoryVolumes.dat");
+        std::ofstream faces(folder + "trajectoryFaces.dat");
+        if (!volumes.good() || !faces.good())
+        {
+            std::cerr << "error: cannot open trajectory files for write" << std::endl;
+            return -1;
+        }
+        volumes << "#1_frame #2_particle label #3_set voronoi cell volume\n";
+        faces << "#1_frame #2_particle label #3_neighbor label #4_face area\n";
+        std::ofstream coherence;
+        if (coherent)
+        {
+            coherence.open(folder + "trajectoryCoherence.dat");
+            coherence << "#1_frame #2_recalculated particles #3_recalculated voronoi cells #4_fraction of recalculated cells\n";
+        }
+
+        // the frames of the coherent diagram depend on each other, so only the reading runs in parallel
+        unsigned int workers = coherent ? 1 : threads;
+        if (coherent) std::cout << "calculating trajectory frames coherently, particles whose surface points moved less than " << threshold << " are not recalculated" << std::endl;
+        else std::cout << "calculating trajectory frames with " << workers << " threads" << std::endl;
+        std::vector<std::thread> pool;
+        pool.push_back(std::thread([this, &pattern]() { read(pattern); }));
+        for (unsigned int t = 0; t != workers; ++t) pool.push_back(std::thread([this]() { work(); }));
+
+        // write the results in frame order as soon as they are finished
+        unsigned long next = 0;
+        {
+            std::unique_lock<std::mutex> lock(m);
+            while (true)
+            {
+                changed.wait(lock, [&]() { return !error.empty() || finished.count(next) || (readerdone && next == frames); });
+                if (!error.empty() || !finished.count(next)) break;
+                auto it = finished.find(next);
+                volumes << it->second.volumes;
+                faces << it->second.faces;
+                if (coherent) coherence << it->second.coherence;
+                finished.erase(it);
+                ++next;
+                std::cout << next << " " << std::flush;
+                changed.notify_all();
+            }
+        }
+        for (std::thread& t : pool) t.join();
+        std::cout << std::endl;
+
+        if (!error.empty())
+        {
+            std::cerr << error << std::endl;
+            return -1;
+        }
+        std::cout << "finished " << next << " frames" << std::endl;
+        if (coherent && allcells > 0) std::cout << "recalculated " << 100.0*static_cast<double>(recalculatedcells)/static_cast<double>(allcells) << " % of the voronoi cells" << std::endl;
+        std::cout << "\nworking for you has been nice. Thank you for using me & see you soon. :) "<< std::endl;
+        return 0;
+    };
+
+private:
+    eMode mode;
+    unsigned int threads;
+
+    std::mutex m;
+    std::condition_variable changed;
+    struct frameresult
+    {
+        std::string volumes;
+        std::string faces;
+        std::string coherence;
+    };
+
+    std::deque<std::pair<unsigned long, std::string> > queue;   // frames read but not calculated yet
+    std::map<unsigned long, frameresult> finished;              // output of calculated frames
+    bool readerdone;
+    unsigned long frames;       // number of frames read
+    std::string error;
+
+    // coherent diagram, only used by the single worker of the coherent mode
+    std::unique_ptr<pomeloincremental> diagram;
+    pomelobox diagrambox;
+    std::vector<std::vector<double> > positions;    // by label, surface points of the particle in the diagram
+    unsigned long sincerefresh;
+    unsigned long long recalculatedcells;
+    unsigned long long allcells;
+
+    void fail(std::string const& e)
+    {
+        std::lock_guard<std::mutex> lock(m);
+        if (error.empty()) error = e;
+        changed.notify_all();
+    };
+
+    // the reader stays at most two frames per thread ahead of the writer
+    void read(std::string const& pattern)
+    {
+        try
+        {
+            trajectoryreader reader(pattern, mode != SPHERE && mode != SPHEREPOLY);
+            std::string frame;
+            while (reader.next(frame))
+            {
+                std::unique_lock<std::mutex> lock(m);
+                changed.wait(lock, [&]() { return !error.empty() || queue.size() + finished.size() < 2*threads; });
+                if (!error.empty()) return;
+                queue.push_back(std::make_pair(frames++, frame));
+                changed.notify_all();
+            }
+        }
+        catch (std::string const& e)
+        {
+            fail(e);
+        }
+        std::lock_guard<std::mutex> lock(m);
+        readerdone = true;
+        changed.notify_all();
+    };
+
+    void work()
+    {
+        parsexyz pxyz;
+        parsexyzr pxyzr;
+        parseellipsoid pellip;
+        parsesphcyl psphcyl;
+        parsepolyhedron ppoly;
+        parsesuperquadric psuperq;
+        pxyz.verbose = false;
+        pxyzr.verbose = false;
+        pellip.verbose = false;
+        psphcyl.verbose = false;
+        ppoly.verbose = false;
+        psuperq.verbose = false;
+        pointpattern pp;
+        setvoronoi sv;
+        sv.verbose = false;
+        sv.mesh = false;
+
+        while (true)
+        {
+            std::pair<unsigned long, std::string> frame;
+            {
+                std::unique_lock<std::mutex> lock(m);
+                changed.wait(lock, [&]() { return !error.empty() || !queue.empty() || readerdone; });
+                if (!error.empty() || queue.empty()) return;
+                frame = queue.front();
+                queue.pop_front();
+            }
+
+            std::ostringstream volumes;
+            std::ostringstream faces;
+            std::ostringstream coherence;
+            volumes << std::setprecision(12);
+            faces << std::setprecision(12);
+            try
+            {
+                pp.clear();
+                std::istringstream text(frame.second);
+                pomelobox box;
+                if (mode == SPHERE)
+                {
+                    pxyz.parse(text, pp);
+                    box = pomelobox{pxyz.xmin, pxyz.xmax, pxyz.ymin, pxyz.ymax, pxyz.zmin, pxyz.zmax, pxyz.xpbc, pxyz.ypbc, pxyz.zpbc};
+                }
+                else if (mode == SPHEREPOLY)
+                {
+                    pxyzr.parse(text, pp);
+                    box = pomelobox{pxyzr.xmin, pxyzr.xmax, pxyzr.ymin, pxyzr.ymax, pxyzr.zmin, pxyzr.zmax, pxyzr.xpbc, pxyzr.ypbc, pxyzr.zpbc};
+                }
+                else if (mode == ELLIP)
+                {
+                    pellip.parse(text, pp);
+                    box = pomelobox{pellip.xmin, pellip.xmax, pellip.ymin, pellip.ymax, pellip.zmin, pellip.zmax, pellip.xpbc, pellip.ypbc, pellip.zpbc};
+                }
+                else if (mode == SPHCYL)
+                {
+                    psphcyl.parse(text, pp);
+                    box = pomelobox{psphcyl.xmin, psphcyl.xmax, psphcyl.ymin, psphcyl.ymax, psphcyl.zmin, psphcyl.zmax, psphcyl.xpbc, psphcyl.ypbc, psphcyl.zpbc};
+                }
+                else if (mode == POLYHEDRON)
+                {
+                    // the parameters of every frame are read first, as for a single polyhedron file
+                    ppoly.readparameters(text);
+                    std::istringstream particles(frame.second);
+                    ppoly.parse(particles, pp);
+                    box = pomelobox{ppoly.xmin, ppoly.xmax, ppoly.ymin, ppoly.ymax, ppoly.zmin, ppoly.zmax, ppoly.xpbc, ppoly.ypbc, ppoly.zpbc};
+                }
+                else
+                {
+                    psuperq.parse(text, pp);
+                    box = pomelobox{psuperq.xmin, psuperq.xmax, psuperq.ymin, psuperq.ymax, psuperq.zmin, psuperq.zmax, psuperq.xpbc, psuperq.ypbc, psuperq.zpbc};
+                }
+                if (pp.points.empty()) throw std::string("frame has no particles");
+
+                if (coherent)
+                {
+                    calculatecoherent(frame.first, pp, box, volumes, faces, coherence);
+                }
+                else
+                {
+                    sv.removeduplicates(pp, 1e-12, box.xmin, box.xmax, box.ymin, box.ymax, box.zmin, box.zmax);
+                    sv.calculate(pp, box.xmin, box.xmax, box.ymin, box.ymax, box.zmin, box.zmax, box.xpbc, box.ypbc, box.zpbc);
+                    for (unsigned long long i = 0; i != sv.volume.size(); ++i)
+                    {
+                        volumes << frame.first << " " << i << " " << sv.volume[i] << "\n";
+                        for (auto const& f : sv.facearea[i])
+                        {
+                            faces << frame.first << " " << i << " " << f.first << " " << f.second << "\n";
+                        }
+                    }
+                }
+            }
+            catch (std::string const& e)
+            {
+                fail("frame " + std::to_string(frame.first) + ": " + e);
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(m);
+            frameresult& r = finished[frame.first];
+            r.volumes = volumes.str();
+            r.faces = faces.str();
+            r.coherence = coherence.str();
+            changed.notify_all();
+        }
+    };
+
+    static bool samebox(pomelobox const& a, pomelobox const& b)
+    {
+        return a.xmin == b.xmin && a.xmax == b.xmax && a.ymin == b.ymin && a.ymax == b.ymax && a.zmin == b.zmin && a.zmax == b.zmax
+            && a.xpbc == b.xpbc && a.ypbc == b.ypbc && a.zpbc == b.zpbc;
+    };
+
+    // particles whose surface points all moved less than the threshold since they were last calculated keep their old
+    // surface points in the diagram, so no surface point in the diagram is further than the threshold from the frame
+    void calculatecoherent(unsigned long frame, pointpattern const& pp, pomelobox const& box, std::ostream& volumes, std::ostream& faces, std::ostream& coherence)
+    {
+        // surface points by particle label, points outside of a non periodic box are left out as by voro++
+        std::vector<std::vector<double> > xyz;
+        unsigned long long points = 0;
+        for (point const& p : pp.points)
+        {
+            if (p.l < 0) throw std::string("negative particle label");
+            if ((!box.xpbc && (p.x < box.xmin || p.x >= box.xmax)) || (!box.ypbc && (p.y < box.ymin || p.y >= box.ymax)) || (!box.zpbc && (p.z < box.zmin || p.z >= box.zmax))) continue;
+            if (xyz.size() <= static_cast<size_t>(p.l)) xyz.resize(p.l + 1);
+            xyz[p.l].push_back(p.x);
+            xyz[p.l].push_back(p.y);
+            xyz[p.l].push_back(p.z);
+            ++points;
+        }
+        unsigned long particles = 0;
+        for (std::vector<double> const& l : xyz) if (!l.empty()) ++particles;
+
+        bool rebuild = !diagram || !samebox(box, diagrambox) || (refresh > 0 && sincerefresh >= refresh) || xyz.size() != positions.size();
+        std::vector<int> moved;
+        if (!rebuild)
+        {
+            double length[3] = {box.xmax - box.xmin, box.ymax - box.ymin, box.zmax - box.zmin};
+            bool pbc[3] = {box.xpbc, box.ypbc, box.zpbc};
+            for (size_t l = 0; l != xyz.size(); ++l)
+            {
+                if (xyz[l].size() != positions[l].size())
+                {
+                    moved.push_back(l);
+                    continue;
+                }
+                // the parsers spawn the surface points of a particle in the same order in every frame, so the largest
+                // displacement of a single point also catches particles that only grew, shrank or rotated
+                for (size_t k = 0; k < xyz[l].size(); k += 3)
+                {
+                    double d2 = 0;
+                    for (int a = 0; a != 3; ++a)
+                    {
+                        // nearest periodic image
+                        double d = xyz[l][k + a] - positions[l][k + a];
+                        if (pbc[a]) d -= length[a]*std::round(d/length[a]);
+                        d2 += d*d;
+                    }
+                    if (d2 > threshold*threshold)
+                    {
+                        moved.push_back(l);
+                        break;
+                    }
+                }
+            }
+            // moving most of the particles costs more than a new diagram
+            if (2*moved.size() > particles) rebuild = true;
+        }
+
+        if (rebuild)
+        {
+            std::vector<double> all;
+            std::vector<int> labels;
+            all.reserve(3*points);
+            labels.reserve(points);
+            for (size_t l = 0; l != xyz.size(); ++l)
+            {
+                all.insert(all.end(), xyz[l].begin(), xyz[l].end());
+                labels.insert(labels.end(), xyz[l].size()/3, static_cast<int>(l));
+            }
+            diagram.reset(new pomeloincremental(all, labels, box));
+            diagrambox = box;
+            positions = xyz;
+            sincerefresh = 0;
+        }
+        else
+        {
+            std::vector<std::vector<double> > movedxyz;
+            for (int l : moved)
+            {
+                movedxyz.push_back(xyz[l]);
+                positions[l] = xyz[l];
+            }
+            diagram->move(moved, movedxyz);
+        }
+        // the diagram merges the repeated points of a particle (e.g. the poles of the theta/phi grid), so it has
+        // fewer cells than surface points
+        unsigned long long cells = diagram->cells();
+        unsigned long long recalculated = rebuild ? cells : diagram->calculatedcells();
+        ++sincerefresh;
+        recalculatedcells += recalculated;
+        allcells += cells;
+
+        pomeloresult r;
+        diagram->result(r);
+        for (size_t i = 0; i != r.volume.size(); ++i)
+        {
+            volumes << frame << " " << i << " " << r.volume[i] << "\n";
+            for (unsigned long k = r.neighboroffset[i]; k != r.neighboroffset[i + 1]; ++k)
+            {
+                faces << frame << " " << i << " " << r.neighbor[k] << " " << r.facearea[k] << "\n";
+            }
+        }
+        coherence << frame << " " << (rebuild ? particles : moved.size()) << " " << recalculated << " " << static_cast<double>(recalculated)/static_cast<double>(cells) << "\n";
+    };
+};
+
+#endif
@@ -24,8 +24,16 @@ The development of Pomelo took place at the Friedrich-Alexander University of Er
 #include <iomanip>
 #include <vector>
 #include <map>
+#include <array>
+#include <utility>
 #include <cmath>
 #include "pointpattern.hpp"
+#include "vec3.hpp"
+
+inline vec3 tovec3(point const& p)
+{
+    return vec3{p.x, p.y, p.z};
+}
 
 class triangle
 {
@@ -42,23 +50,14 @@ public:
     
     void getPlaneEquationCoefficients(double& a, double& b, double& c, double& d)
     {
-        double e1x = p[1].x - p[0].x;
-        double e1y = p[1].y - p[0].y;
-        double e1z = p[1].z - p[0].z;
-
-        double e2x = p[2].x - p[0].x;
-        double e2y = p[2].y - p[0].y;
-        double e2z = p[2].z - p[0].z;
-        
-        double nx = e1y*e2z - e1z*e2y;
-        double ny = e1z*e2x - e1x*e2z;
-        double nz = e1x*e2y - e1y*e2x;
-        
-        a = nx;
-        b = ny;
-        c = nz;
-
-        d = -a * p[0].x - b * p[0].y - c*p[0].z;
+        vec3 p0 = tovec3(p[0]);
+        vec3 n = cross(tovec3(p[1]) - p0, tovec3(p[2]) - p0);
+
+        a = n.x;
+        b = n.y;
+        c = n.z;
+
+        d = -dot(n, p0);
     }
 
     static void recusiveSubdivide (unsigned int depth, std::vector<triangle>& tris)
@@ -79,6 +78,7 @@ public:
     };
 
 
+    // subdivision that copies all three corners for every triangle, shared edges and corners are emitted multiple times
     std::vector<triangle> subdivide()
     {
         std::vector<triangle> ret;
@@ -101,4 +101,61 @@ public:
 };
 
 
+// indexed triangle mesh, every vertex is stored only once and the triangles refer to the vertex indices
+class trianglemesh
+{
+public:
+    std::vector<vec3> vertices;
+    std::vector<std::array<unsigned int, 3> > triangles;
+
+    unsigned int addvertex(vec3 const& v)
+    {
+        vertices.push_back(v);
+        return vertices.size() - 1;
+    };
+
+    void addtriangle(unsigned int a, unsigned int b, unsigned int c)
+    {
+        triangles.push_back({{a, b, c}});
+    };
+
+    // split every triangle into four. The midpoint of every edge is created only once (the edge map holds the midpoint
+    // index of all edges that have already been split), so the vertices stay unique and no duplication check is needed
+    void subdivide(unsigned int depth)
+    {
+        for(unsigned int i = 0; i != depth; ++i)
+        {
+            std::map<std::pair<unsigned int, unsigned int>, unsigned int> edgemap;
+            std::vector<std::array<unsigned int, 3> > triangles2;
+            triangles2.reserve(4*triangles.size());
+            for (auto it = triangles.begin(); it != triangles.end(); ++it)
+            {
+                unsigned int a = (*it)[0];
+                unsigned int b = (*it)[1];
+                unsigned int c = (*it)[2];
+                unsigned int ab = midpoint(a, b, edgemap);
+                unsigned int bc = midpoint(b, c, edgemap);
+                unsigned int ca = midpoint(c, a, edgemap);
+                triangles2.push_back({{a, ab, ca}});
+                triangles2.push_back({{b, bc, ab}});
+                triangles2.push_back({{c, ca, bc}});
+                triangles2.push_back({{ab, bc, ca}});
+            }
+            std::swap(triangles, triangles2);
+        }
+    };
+
+private:
+    unsigned int midpoint(unsigned int a, unsigned int b, std::map<std::pair<unsigned int, unsigned int>, unsigned int>& edgemap)
+    {
+        std::pair<unsigned int, unsigned int> edge = (a < b) ? std::make_pair(a, b) : std::make_pair(b, a);
+        auto it = edgemap.find(edge);
+        if (it != edgemap.end()) return it->second;
+        unsigned int m = addvertex( (vertices[a] + vertices[b]) * 0.5 );
+        edgemap[edge] = m;
+        return m;
+    };
+};
+
+
 #endif
@@ -0,0 +1,126 @@
+/* 
+Copyright 2016 Simon Weis and Philipp Schoenhoefer
+
+This file is part of Pomelo.
+
+Pomelo is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Pomelo is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Pomelo.  If not, see <http://www.gnu.org/licenses/>.
+
+The development of Pomelo took place at the Friedrich-Alexander University of Erlangen and was funded by the German Research Foundation (DFG) Forschergruppe FOR1548 "Geometry and Physics of Spatial Random Systems" (GPSRS). 
+*/
+#ifndef VEC3_H_GUARD_123456
+#define VEC3_H_GUARD_123456
+
+#include <cmath>
+
+// lightweight 3-vector and 3x3-matrix for the shape generation
+// both are trivially copyable aggregates without virtual functions, so the compiler can keep them in registers
+
+struct vec3
+{
+    double x, y, z;
+
+    double length() const
+    {
+        return std::sqrt(x*x + y*y + z*z);
+    };
+};
+
+constexpr vec3 operator+ (vec3 const& a, vec3 const& b)
+{
+    return vec3{a.x + b.x, a.y + b.y, a.z + b.z};
+}
+
+constexpr vec3 operator- (vec3 const& a, vec3 const& b)
+{
+    return vec3{a.x - b.x, a.y - b.y, a.z - b.z};
+}
+
+constexpr vec3 operator- (vec3 const& a)
+{
+    return vec3{-a.x, -a.y, -a.z};
+}
+
+constexpr vec3 operator* (vec3 const& a, double f)
+{
+    return vec3{a.x * f, a.y * f, a.z * f};
+}
+
+constexpr vec3 operator* (double f, vec3 const& a)
+{
+    return vec3{a.x * f, a.y * f, a.z * f};
+}
+
+constexpr double dot (vec3 const& a, vec3 const& b)
+{
+    return a.x*b.x + a.y*b.y + a.z*b.z;
+}
+
+constexpr vec3 cross (vec3 const& a, vec3 const& b)
+{
+    return vec3{a.y*b.z - a.z*b.y, a.z*b.x - a.x*b.z, a.x*b.y - a.y*b.x};
+}
+
+inline vec3 normalize (vec3 const& a)
+{
+    return a * (1.0/a.length());
+}
+
+
+// 3x3 matrix, stored row by row
+struct mat3
+{
+    double m[9];
+
+    static constexpr mat3 identity()
+    {
+        return mat3{{1,0,0, 0,1,0, 0,0,1}};
+    };
+
+    // matrix with the columns c1, c2, c3
+    static constexpr mat3 fromcolumns(vec3 const& c1, vec3 const& c2, vec3 const& c3)
+    {
+        return mat3{{c1.x, c2.x, c3.x, c1.y, c2.y, c3.y, c1.z, c2.z, c3.z}};
+    };
+
+    constexpr vec3 row(int i) const
+    {
+        return vec3{m[3*i], m[3*i+1], m[3*i+2]};
+    };
+
+    constexpr vec3 column(int i) const
+    {
+        return vec3{m[i], m[3+i], m[6+i]};
+    };
+
+    constexpr mat3 transpose() const
+    {
+        return mat3{{m[0], m[3], m[6], m[1], m[4], m[7], m[2], m[5], m[8]}};
+    };
+};
+
+constexpr vec3 operator* (mat3 const& a, vec3 const& v)
+{
+    return vec3{a.m[0]*v.x + a.m[1]*v.y + a.m[2]*v.z,
+                a.m[3]*v.x + a.m[4]*v.y + a.m[5]*v.z,
+                a.m[6]*v.x + a.m[7]*v.y + a.m[8]*v.z};
+}
+
+constexpr mat3 operator* (mat3 const& a, mat3 const& b)
+{
+    return mat3{{dot(a.row(0), b.column(0)), dot(a.row(0), b.column(1)), dot(a.row(0), b.column(2)),
+                 dot(a.row(1), b.column(0)), dot(a.row(1), b.column(1)), dot(a.row(1), b.column(2)),
+                 dot(a.row(2), b.column(0)), dot(a.row(2), b.column(1)), dot(a.row(2), b.column(2))}};
+}
+
+#endif
@@ -0,0 +1,347 @@
+/* 
+Copyright 2016 Simon Weis and Philipp Schoenhoefer
+
+This file is part of Pomelo.
+
+Pomelo is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Pomelo is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Pomelo.  If not, see <http://www.gnu.org/licenses/>.
+
+The development of Pomelo took place at the Friedrich-Alexander University of Erlangen and was funded by the German Research Foundation (DFG) Forschergruppe FOR1548 "Geometry and Physics of Spatial Random Systems" (GPSRS). 
+*/
+#ifndef VORONOI2D_H_GUARD_123456
+#define VORONOI2D_H_GUARD_123456
+
+#include <vector>
+#include <map>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include "pointpattern.hpp"
+
+// set voronoi diagram in the plane, the z coordinates of the points are ignored
+// every voronoi cell of a surface point is the box (or, for periodic axes, the box sized rectangle around the point)
+// clipped by the bisectors of the surrounding points. The points are sorted into a grid of bins that is searched ring
+// by ring until no further point can cut the cell. Every edge knows the label of the point on its other side, so the
+// merge by label is exact: edges between points of the same particle are dropped, the others form the cells
+class voronoi2d
+{
+public:
+    bool verbose;           // progress output on std::cout
+    unsigned int nx, ny;    // number of bins
+    std::vector<double> area;                                   // by particle label
+    std::vector<std::map<unsigned int, double> > edgelength;    // by particle label, boundary length to every neighbor label
+    std::vector<std::vector<std::vector<double> > > polygons;   // by particle label, closed outlines as x0 y0 x1 y1 ...
+
+    voronoi2d () : verbose(true), nx(0), ny(0)
+    {};
+
+    void calculate(pointpattern const& pp, double xmin, double xmax, double ymin, double ymax, bool xpbc, bool ypbc)
+    {
+        lx = xmax - xmin;
+        ly = ymax - ymin;
+        if (lx <= 0 || ly <= 0) throw std::string("2d box has no area");
+        size_t const n = pp.points.size();
+        if (n == 0) throw std::string("no points for the 2d voronoi diagram");
+
+        // about three points per bin
+        double binsize = std::sqrt(3.0*lx*ly/static_cast<double>(n));
+        nx = std::max(1u, static_cast<unsigned int>(lx/binsize));
+        ny = std::max(1u, static_cast<unsigned int>(ly/binsize));
+        bx = lx/nx;
+        by = ly/ny;
+        if (verbose) std::cout << "2d voronoi diagram with " << n << " points in (" << nx << " " << ny << ") bins" << std::endl;
+
+        // points in periodic directions are wrapped into the box
+        x.resize(n);
+        y.resize(n);
+        l.resize(n);
+        int maxlabel = 0;
+        for (size_t i = 0; i != n; ++i)
+        {
+            point const& p = pp.points[i];
+            x[i] = p.x - xmin;
+            y[i] = p.y - ymin;
+            if (xpbc) x[i] -= lx*std::floor(x[i]/lx);
+            if (ypbc) y[i] -= ly*std::floor(y[i]/ly);
+            l[i] = p.l;
+            if (p.l < 0) throw std::string("negative particle label in the 2d voronoi diagram");
+            maxlabel = std::max(maxlabel, p.l);
+        }
+        bins.assign(static_cast<size_t>(nx)*ny, std::vector<unsigned int>());
+        for (size_t i = 0; i != n; ++i)
+        {
+            bins[static_cast<size_t>(binindex(y[i], by, ny))*nx + binindex(x[i], bx, nx)].push_back(static_cast<unsigned int>(i));
+        }
+
+        area.assign(maxlabel + 1, 0);
+        edgelength.assign(maxlabel + 1, std::map<unsigned int, double>());
+        polygons.assign(maxlabel + 1, std::vector<std::vector<double> >());
+
+        // the outlines are unwrapped around the first point of every particle
+        std::vector<long> reference(maxlabel + 1, -1);
+        for (size_t i = 0; i != n; ++i)
+        {
+            if (reference[l[i]] < 0) reference[l[i]] = static_cast<long>(i);
+        }
+        std::vector<std::vector<double> > outline(maxlabel + 1);     // boundary edges as x0 y0 x1 y1
+        double const tolerance = 1e-9*std::max(lx, ly);
+
+        unsigned int percent = 0;
+        if (verbose) std::cout << "calculating 2d voronoi cells ";
+        cell c;
+        for (size_t i = 0; i != n; ++i)
+        {
+            computecell(i, xpbc, ypbc, c);
+
+            double ox = x[i];
+            double oy = y[i];
+            size_t const r = static_cast<size_t>(reference[l[i]]);
+            if (xpbc) ox -= lx*std::round((x[i] - x[r])/lx);
+            if (ypbc) oy -= ly*std::round((y[i] - y[r])/ly);
+
+            size_t const m = c.x.size();
+            double a = 0;
+            for (size_t k = 0; k != m; ++k)
+            {
+                size_t const k1 = (k + 1)%m;
+                a += c.x[k]*c.y[k1] - c.x[k1]*c.y[k];
+                int const nl = c.neighbor[k];
+                if (nl == l[i]) continue;
+
+                double const length = std::hypot(c.x[k1] - c.x[k], c.y[k1] - c.y[k]);
+                if (nl >= 0) edgelength[l[i]][static_cast<unsigned int>(nl)] += length;
+                if (length <= tolerance) continue;
+                std::vector<double>& o = outline[l[i]];
+                o.push_back(xmin + ox + c.x[k]);
+                o.push_back(ymin + oy + c.y[k]);
+                o.push_back(xmin + ox + c.x[k1]);
+                o.push_back(ymin + oy + c.y[k1]);
+            }
+            area[l[i]] += 0.5*a;
+
+            while (verbose && percent < (100*(i + 1))/n)
+            {
+                percent += 10;
+                std::cout << percent << " % " << std::flush;
+            }
+        }
+        if (verbose) std::cout << std::endl;
+
+        for (size_t i = 0; i != outline.size(); ++i)
+        {
+            chain(outline[i], tolerance, polygons[i]);
+        }
+    };
+
+    // one closed outline per block, the first vertex is repeated at the end (gnuplot: plot "cell.xy" with lines)
+    void save(std::string const& filename) const
+    {
+        std::ofstream out(filename);
+        if (!out.good()) throw std::string("error: cannot open " + filename + " for write");
+        out << "#1_x #2_y, one outline per block\n";
+        out << std::setprecision(12);
+        for (size_t i = 0; i != polygons.size(); ++i)
+        {
+            for (std::vector<double> const& p : polygons[i])
+            {
+                out << "# particle " << i << "\n";
+                for (size_t k = 0; k + 1 < p.size(); k += 2) out << p[k] << " " << p[k+1] << "\n";
+                out << "\n\n";
+            }
+        }
+    };
+
+private:
+    double lx, ly;      // box
+    double bx, by;      // bin size
+    std::vector<double> x, y;
+    std::vector<int> l;
+    std::vector<std::vector<unsigned int> > bins;
+
+    // convex polygon around a point, counter clockwise and relative to the point. Edge k runs from vertex k to k+1
+    // and borders the particle neighbor[k], -1 is a wall
+    struct cell
+    {
+        std::vector<double> x, y;
+        std::vector<int> neighbor;
+    };
+
+    static unsigned int binindex(double v, double b, unsigned int n)
+    {
+        long i = static_cast<long>(std::floor(v/b));
+        if (i < 0) return 0;
+        if (i >= static_cast<long>(n)) return n - 1;
+        return static_cast<unsigned int>(i);
+    };
+
+    void computecell(size_t i, bool xpbc, bool ypbc, cell& c) const
+    {
+        // start with the box, or with the box sized rectangle around the point for periodic axes.
+        // the edges of the periodic rectangle are the bisectors to the images of the point itself
+        double const x0 = xpbc ? -0.5*lx : -x[i];
+        double const x1 = xpbc ? 0.5*lx : lx - x[i];
+        double const y0 = ypbc ? -0.5*ly : -y[i];
+        double const y1 = ypbc ? 0.5*ly : ly - y[i];
+        c.x = {x0, x1, x1, x0};
+        c.y = {y0, y0, y1, y1};
+        int const wx = xpbc ? l[i] : -1;
+        int const wy = ypbc ? l[i] : -1;
+        c.neighbor = {wy, wx, wy, wx};
+
+        long const ix = binindex(x[i], bx, nx);
+        long const iy = binindex(y[i], by, ny);
+        double const bmin = std::min(bx, by);
+        for (long ring = 0; ; ++ring)
+        {
+            // no point in this ring or further out can cut the cell any more
+            double rmax = 0;
+            for (size_t k = 0; k != c.x.size(); ++k) rmax = std::max(rmax, c.x[k]*c.x[k] + c.y[k]*c.y[k]);
+            double const reach = (ring - 1)*bmin;
+            if (reach > 0 && reach*reach >= 4*rmax) break;
+            if (!xpbc && !ypbc && ring > static_cast<long>(std::max(nx, ny))) break;
+
+            for (long jy = iy - ring; jy <= iy + ring; ++jy)
+            {
+                long const sy = static_cast<long>(std::floor(static_cast<double>(jy)/ny));
+                if (!ypbc && sy != 0) continue;
+                bool const rowedge = (jy == iy - ring || jy == iy + ring);
+                for (long jx = ix - ring; jx <= ix + ring; ++jx)
+                {
+                    if (!rowedge && jx != ix - ring && jx != ix + ring) continue;
+                    long const sx = static_cast<long>(std::floor(static_cast<double>(jx)/nx));
+                    if (!xpbc && sx != 0) continue;
+
+                    // the bin and the periodic image it is seen in
+                    double const shiftx = sx*lx;
+                    double const shifty = sy*ly;
+                    std::vector<unsigned int> const& b = bins[static_cast<size_t>(jy - sy*ny)*nx + (jx - sx*nx)];
+                    for (unsigned int j : b)
+                    {
+                        if (j == i && sx == 0 && sy == 0) continue;
+                        clip(c, x[j] + shiftx - x[i], y[j] + shifty - y[i], l[j]);
+                    }
+                }
+            }
+        }
+    };
+
+    // cut the cell by the bisector to the point (dx, dy), relative to the cell center
+    static void clip(cell& c, double dx, double dy, int label)
+    {
+        double const half = 0.5*(dx*dx + dy*dy);
+        if (half == 0) return;
+        size_t const m = c.x.size();
+        double const tolerance = 1e-12*half;
+        bool outside = false;
+        for (size_t k = 0; k != m; ++k)
+        {
+            if (c.x[k]*dx + c.y[k]*dy - half > tolerance)
+            {
+                outside = true;
+                break;
+            }
+        }
+        if (!outside) return;
+
+        // sutherland hodgman for one half plane, the new edge along the bisector borders the cutting point
+        cell out;
+        for (size_t k = 0; k != m; ++k)
+        {
+            size_t const k1 = (k + 1)%m;
+            double const sa = c.x[k]*dx + c.y[k]*dy - half;
+            double const sb = c.x[k1]*dx + c.y[k1]*dy - half;
+            if (sa <= 0)
+            {
+                out.x.push_back(c.x[k]);
+                out.y.push_back(c.y[k]);
+                out.neighbor.push_back(c.neighbor[k]);
+                if (sb > 0)
+                {
+                    double const t = sa/(sa - sb);
+                    out.x.push_back(c.x[k] + t*(c.x[k1] - c.x[k]));
+                    out.y.push_back(c.y[k] + t*(c.y[k1] - c.y[k]));
+                    out.neighbor.push_back(label);
+                }
+            }
+            else if (sb <= 0)
+            {
+                double const t = sa/(sa - sb);
+                out.x.push_back(c.x[k] + t*(c.x[k1] - c.x[k]));
+                out.y.push_back(c.y[k] + t*(c.y[k1] - c.y[k]));
+                out.neighbor.push_back(c.neighbor[k]);
+            }
+        }
+        std::swap(c, out);
+    };
+
+    // join the boundary edges of one particle to closed outlines. The end of one edge and the start of the next one
+    // are the same voronoi vertex, calculated in two different cells, so they are matched with a small tolerance
+    static void chain(std::vector<double> const& edges, double tolerance, std::vector<std::vector<double> >& result)
+    {
+        size_t const n = edges.size()/4;
+        std::multimap<std::pair<long long, long long>, size_t> starts;
+        auto key = [tolerance](double vx, double vy)
+        {
+            return std::make_pair(std::llround(vx/tolerance), std::llround(vy/tolerance));
+        };
+        for (size_t e = 0; e != n; ++e) starts.insert(std::make_pair(key(edges[4*e], edges[4*e + 1]), e));
+
+        std::vector<bool> used(n, false);
+        for (size_t first = 0; first != n; ++first)
+        {
+            if (used[first]) continue;
+            std::vector<double> p;
+            size_t e = first;
+            while (true)
+            {
+                used[e] = true;
+                p.push_back(edges[4*e]);
+                p.push_back(edges[4*e + 1]);
+
+                // the next unused edge that starts where this one ends
+                double const ex = edges[4*e + 2];
+                double const ey = edges[4*e + 3];
+                std::pair<long long, long long> const k = key(ex, ey);
+                long next = -1;
+                for (long ddx = -1; ddx <= 1 && next < 0; ++ddx)
+                {
+                    for (long ddy = -1; ddy <= 1 && next < 0; ++ddy)
+                    {
+                        auto range = starts.equal_range(std::make_pair(k.first + ddx, k.second + ddy));
+                        for (auto it = range.first; it != range.second; ++it)
+                        {
+                            if (used[it->second]) continue;
+                            if (std::fabs(edges[4*it->second] - ex) > tolerance || std::fabs(edges[4*it->second + 1] - ey) > tolerance) continue;
+                            next = static_cast<long>(it->second);
+                            break;
+                        }
+                    }
+                }
+                if (next < 0)
+                {
+                    p.push_back(ex);
+                    p.push_back(ey);
+                    break;
+                }
+                e = static_cast<size_t>(next);
+            }
+            result.push_back(p);
+        }
+    };
+};
+
+#endif
@@ -0,0 +1,411 @@
+/* 
+Copyright 2016 Simon Weis and Philipp Schoenhoefer
+
+This file is part of Pomelo.
+
+Pomelo is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Pomelo is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Pomelo.  If not, see <http://www.gnu.org/licenses/>.
+
+The development of Pomelo took place at the Friedrich-Alexander University of Erlangen and was funded by the German Research Foundation (DFG) Forschergruppe FOR1548 "Geometry and Physics of Spatial Random Systems" (GPSRS). 
+*/
+#ifndef VOXELGRID_H_GUARD_123456
+#define VOXELGRID_H_GUARD_123456
+
+#include <vector>
+#include <map>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <thread>
+#include <iostream>
+#include "pointpattern.hpp"
+#include "shapetemplate.hpp"
+#include "vec3.hpp"
+
+// approximate set voronoi diagram on a voxel grid
+// the particles are rasterized onto a label grid, either as solids straight from their parsed shapes (no surface points
+// are spawned, so the number of particles is only limited by the grid) or from their surface points. An exact
+// euclidean distance transform (Felzenszwalb & Huttenlocher, one lower envelope of parabolas per row and axis) then
+// assigns every voxel the label of the nearest rasterized voxel. volumes, neighbors and contact areas are counted on
+// the grid.
+// memory: 8 bytes per voxel (squared distance and label)
+class voxelgrid
+{
+public:
+    unsigned int nx, ny, nz;    // number of voxels
+    double hx, hy, hz;          // voxel size
+    std::vector<int> label;     // particle label of every voxel, -1 if there is no particle at all
+
+    std::vector<double> volume;                             // by particle label
+    std::vector<std::map<unsigned int, double> > facearea; // by particle label, contact area to every neighbor label
+
+    // n is the number of voxels along the longest box edge, the distance transform runs on threads threads
+    voxelgrid (unsigned int n, unsigned int t) : nx(0), ny(0), nz(0), hx(0), hy(0), hz(0), resolution(n), threads(std::max(1u, t)), maxlabel(0)
+    {};
+
+    // allocate the empty grid, has to be called before the particles are added
+    void setup(double xmin, double xmax, double ymin, double ymax, double zmin, double zmax, bool xpbc, bool ypbc, bool zpbc)
+    {
+        double lx = xmax - xmin;
+        double ly = ymax - ymin;
+        double lz = zmax - zmin;
+        double h = std::max(lx, std::max(ly, lz))/static_cast<double>(resolution);
+        nx = std::max(1u, static_cast<unsigned int>(std::round(lx/h)));
+        ny = std::max(1u, static_cast<unsigned int>(std::round(ly/h)));
+        nz = std::max(1u, static_cast<unsigned int>(std::round(lz/h)));
+        hx = lx/nx;
+        hy = ly/ny;
+        hz = lz/nz;
+        origin = vec3{xmin, ymin, zmin};
+        pbc[0] = xpbc;
+        pbc[1] = ypbc;
+        pbc[2] = zpbc;
+        std::cout << "voxel grid (" << nx << " " << ny << " " << nz << ") with " << 8.0e-9*nx*ny*nz << " GB" << std::endl;
+        distance.assign(static_cast<size_t>(nx)*ny*nz, std::numeric_limits<float>::infinity());
+        label.assign(distance.size(), -1);
+        maxlabel = 0;
+    };
+
+    bool ready() const
+    {
+        return !label.empty();
+    };
+
+    // the voxels that contain a surface point, the distance is measured from voxel center to voxel center
+    void addpoints(pointpattern const& pp)
+    {
+        for (point const& p : pp.points)
+        {
+            long i = cellindex(p.x - origin.x, hx, nx, pbc[0]);
+            long j = cellindex(p.y - origin.y, hy, ny, pbc[1]);
+            long k = cellindex(p.z - origin.z, hz, nz, pbc[2]);
+            if (i < 0 || j < 0 || k < 0) continue;
+            mark(index(i, j, k), p.l);
+        }
+    };
+
+    void addsphere(int l, double x, double y, double z, double r)
+    {
+        vec3 c{x, y, z};
+        vec3 d{r, r, r};
+        addsolid(l, c, c - d, c + d, [&](vec3 const& p) { return dot(p - c, p - c) <= r*r; });
+    };
+
+    // ellipsoid with semi-axes a, b, c along the body axes of t, the rotation of t has to be orthonormal
+    void addellipsoid(int l, rigidtransform const& t, double a, double b, double c)
+    {
+        vec3 lo, hi;
+        extent(t, vec3{a, b, c}, lo, hi);
+        mat3 inv = t.r.transpose();
+        addsolid(l, t.t, lo, hi, [&](vec3 const& p)
+        {
+            vec3 q = inv*(p - t.t);
+            return q.x*q.x/(a*a) + q.y*q.y/(b*b) + q.z*q.z/(c*c) <= 1;
+        });
+    };
+
+    // spherocylinder with radius r and length len of the cylinder part along the body z axis of t (orthonormal)
+    void addspherocylinder(int l, rigidtransform const& t, double r, double len)
+    {
+        vec3 lo, hi;
+        extent(t, vec3{r, r, r + len/2}, lo, hi);
+        mat3 inv = t.r.transpose();
+        addsolid(l, t.t, lo, hi, [&](vec3 const& p)
+        {
+            vec3 q = inv*(p - t.t);
+            q.z -= std::max(-len/2, std::min(len/2, q.z));
+            return dot(q, q) <= r*r;
+        });
+    };
+
+    // tetrahedron with the corners c
+    void addtetrahedron(int l, std::vector<point> const& c)
+    {
+        vec3 v[4];
+        vec3 center{0, 0, 0};
+        vec3 lo{std::numeric_limits<double>::max(), std::numeric_limits<double>::max(), std::numeric_limits<double>::max()};
+        vec3 hi = -lo;
+        for (int i = 0; i != 4; ++i)
+        {
+            v[i] = vec3{c[i].x, c[i].y, c[i].z};
+            center = center + v[i]*0.25;
+            lo = vec3{std::min(lo.x, v[i].x), std::min(lo.y, v[i].y), std::min(lo.z, v[i].z)};
+            hi = vec3{std::max(hi.x, v[i].x), std::max(hi.y, v[i].y), std::max(hi.z, v[i].z)};
+        }
+        // inward normal of the face opposite to every corner
+        vec3 n[4];
+        for (int i = 0; i != 4; ++i)
+        {
+            vec3 const& a = v[(i + 1) % 4];
+            n[i] = cross(v[(i + 2) % 4] - a, v[(i + 3) % 4] - a);
+            if (dot(n[i], v[i] - a) < 0) n[i] = -n[i];
+        }
+        addsolid(l, center, lo, hi, [&](vec3 const& p)
+        {
+            for (int i = 0; i != 4; ++i)
+            {
+                if (dot(n[i], p - v[(i + 1) % 4]) < 0) return false;
+            }
+            return true;
+        });
+    };
+
+    // distance transform and counting, after all particles have been added
+    void calculate()
+    {
+        // one distance transform per axis, the rows of every axis are distributed over the threads
+        transform(0, nx, ny*nz, hx);
+        transform(1, ny, nx*nz, hy);
+        transform(2, nz, nx*ny, hz);
+        distance = std::vector<float>();
+
+        count();
+    };
+
+private:
+    unsigned int resolution;
+    unsigned int threads;
+    vec3 origin;
+    bool pbc[3];
+    std::vector<float> distance;    // squared distance to the nearest rasterized voxel
+    unsigned int maxlabel;
+
+    // a voxel belongs to the first particle that covers it
+    void mark(size_t i, int l)
+    {
+        if (label[i] >= 0) return;
+        label[i] = l;
+        distance[i] = 0;
+        if (static_cast<unsigned int>(l) > maxlabel) maxlabel = l;
+    };
+
+    // the voxels between lo and hi whose centers are inside the particle. A particle that covers no voxel center gets
+    // the voxel of its center, so that it keeps a cell
+    template <typename F> void addsolid(int l, vec3 const& center, vec3 const& lo, vec3 const& hi, F inside)
+    {
+        double h[3] = {hx, hy, hz};
+        unsigned int n[3] = {nx, ny, nz};
+        double from[3] = {lo.x - origin.x, lo.y - origin.y, lo.z - origin.z};
+        double to[3] = {hi.x - origin.x, hi.y - origin.y, hi.z - origin.z};
+        long first[3], last[3];
+        for (int a = 0; a != 3; ++a)
+        {
+            first[a] = static_cast<long>(std::ceil(from[a]/h[a] - 0.5));
+            last[a] = static_cast<long>(std::floor(to[a]/h[a] - 0.5));
+            if (!pbc[a])
+            {
+                first[a] = std::max(first[a], 0l);
+                last[a] = std::min(last[a], static_cast<long>(n[a]) - 1);
+            }
+        }
+        bool covered = false;
+        for (long k = first[2]; k <= last[2]; ++k)
+        for (long j = first[1]; j <= last[1]; ++j)
+        for (long i = first[0]; i <= last[0]; ++i)
+        {
+            vec3 p{origin.x + (i + 0.5)*hx, origin.y + (j + 0.5)*hy, origin.z + (k + 0.5)*hz};
+            if (!inside(p)) continue;
+            covered = true;
+            mark(index(wrap(i, nx), wrap(j, ny), wrap(k, nz)), l);
+        }
+        if (covered) return;
+        long i = cellindex(center.x - origin.x, hx, nx, pbc[0]);
+        long j = cellindex(center.y - origin.y, hy, ny, pbc[1]);
+        long k = cellindex(center.z - origin.z, hz, nz, pbc[2]);
+        if (i >= 0 && j >= 0 && k >= 0) mark(index(i, j, k), l);
+    };
+
+    // bounding box of the box with the half edges e in the body frame of t
+    static void extent(rigidtransform const& t, vec3 const& e, vec3& lo, vec3& hi)
+    {
+        vec3 d{std::fabs(t.r.m[0])*e.x + std::fabs(t.r.m[1])*e.y + std::fabs(t.r.m[2])*e.z,
+               std::fabs(t.r.m[3])*e.x + std::fabs(t.r.m[4])*e.y + std::fabs(t.r.m[5])*e.z,
+               std::fabs(t.r.m[6])*e.x + std::fabs(t.r.m[7])*e.y + std::fabs(t.r.m[8])*e.z};
+        lo = t.t - d;
+        hi = t.t + d;
+    };
+
+    static size_t wrap(long i, unsigned int n)
+    {
+        i %= static_cast<long>(n);
+        if (i < 0) i += n;
+        return i;
+    };
+
+    size_t index(size_t i, size_t j, size_t k) const
+    {
+        return i + nx*(j + ny*k);
+    };
+
+    static long cellindex(double x, double h, unsigned int n, bool periodic)
+    {
+        long i = static_cast<long>(std::floor(x/h));
+        if (periodic)
+        {
+            i %= static_cast<long>(n);
+            if (i < 0) i += n;
+            return i;
+        }
+        if (i < 0 || i >= static_cast<long>(n)) return -1;
+        return i;
+    };
+
+    // first voxel and stride of row r along axis
+    void row(unsigned int axis, size_t r, size_t& start, size_t& stride) const
+    {
+        if (axis == 0)
+        {
+            start = nx*r;
+            stride = 1;
+        }
+        else if (axis == 1)
+        {
+            start = (r % nx) + static_cast<size_t>(nx)*ny*(r / nx);
+            stride = nx;
+        }
+        else
+        {
+            start = r;
+            stride = static_cast<size_t>(nx)*ny;
+        }
+    };
+
+    void transform(unsigned int axis, unsigned int n, size_t rows, double h)
+    {
+        std::vector<std::thread> workers;
+        for (unsigned int t = 0; t != threads; ++t)
+        {
+            workers.push_back(std::thread([&, t]()
+            {
+                // a periodic row is unrolled three times, so the lower envelope sees the neighboring images
+                unsigned int m = pbc[axis] ? 3*n : n;
+                std::vector<double> f(m);
+                std::vector<int> l(m);
+                std::vector<double> d(m);
+                std::vector<int> ld(m);
+                std::vector<int> v(m);
+                std::vector<double> z(m+1);
+                for (size_t r = t; r < rows; r += threads)
+                {
+                    size_t start, stride;
+                    row(axis, r, start, stride);
+                    for (unsigned int q = 0; q != m; ++q)
+                    {
+                        size_t i = start + stride*(q % n);
+                        f[q] = distance[i];
+                        l[q] = label[i];
+                    }
+                    envelope(f, l, m, h, v, z, d, ld);
+                    unsigned int offset = pbc[axis] ? n : 0;
+                    for (unsigned int q = 0; q != n; ++q)
+                    {
+                        size_t i = start + stride*q;
+                        distance[i] = d[q + offset];
+                        label[i] = ld[q + offset];
+                    }
+                }
+            }));
+        }
+        for (auto& w : workers) w.join();
+    };
+
+    // d(p) = min_q h^2 (p-q)^2 + f(q), ld(p) = l(argmin)
+    static void envelope(std::vector<double> const& f, std::vector<int> const& l, unsigned int n, double h, std::vector<int>& v, std::vector<double>& z, std::vector<double>& d, std::vector<int>& ld)
+    {
+        double h2 = h*h;
+        int k = -1;
+        for (unsigned int q = 0; q != n; ++q)
+        {
+            if (std::isinf(f[q])) continue;
+            double s = -std::numeric_limits<double>::infinity();
+            while (k >= 0)
+            {
+                s = ((f[q] + h2*q*q) - (f[v[k]] + h2*v[k]*v[k]))/(2.0*h2*(q - v[k]));
+                if (s > z[k]) break;
+                --k;
+            }
+            ++k;
+            v[k] = q;
+            z[k] = (k == 0) ? -std::numeric_limits<double>::infinity() : s;
+            z[k+1] = std::numeric_limits<double>::infinity();
+        }
+        if (k < 0)
+        {
+            for (unsigned int q = 0; q != n; ++q)
+            {
+                d[q] = std::numeric_limits<double>::infinity();
+                ld[q] = -1;
+            }
+            return;
+        }
+        int j = 0;
+        for (unsigned int q = 0; q != n; ++q)
+        {
+            while (z[j+1] < q) ++j;
+            double dq = static_cast<double>(q) - v[j];
+            d[q] = h2*dq*dq + f[v[j]];
+            ld[q] = l[v[j]];
+        }
+    };
+
+    // the voxel faces between two cells form a staircase, which overestimates an inclined face with the normal n by the
+    // factor |nx| + |ny| + |nz| (up to sqrt(3)). The faces are therefore counted per axis, which gives the areas of the
+    // projections of the contact onto the three coordinate planes, and combined as sqrt(Ax^2 + Ay^2 + Az^2). This is
+    // exact for flat contacts and underestimates curved ones slightly (by the spread of their normals)
+    void count()
+    {
+        volume.assign(maxlabel+1, 0);
+        std::vector<std::map<unsigned int, std::array<double, 3> > > projected(maxlabel+1);
+        double cell = hx*hy*hz;
+        double area[3] = {hy*hz, hx*hz, hx*hy};
+        for (unsigned int k = 0; k != nz; ++k)
+        for (unsigned int j = 0; j != ny; ++j)
+        for (unsigned int i = 0; i != nx; ++i)
+        {
+            int a = label[index(i, j, k)];
+            if (a < 0) continue;
+            volume[a] += cell;
+
+            // faces to the next voxel in +x, +y and +z
+            unsigned int c[3] = {i, j, k};
+            unsigned int n[3] = {nx, ny, nz};
+            for (unsigned int axis = 0; axis != 3; ++axis)
+            {
+                unsigned int o[3] = {i, j, k};
+                o[axis] = c[axis] + 1;
+                if (o[axis] == n[axis])
+                {
+                    if (!pbc[axis]) continue;
+                    o[axis] = 0;
+                }
+                int b = label[index(o[0], o[1], o[2])];
+                if (b < 0 || b == a) continue;
+                projected[std::min(a, b)][std::max(a, b)][axis] += area[axis];
+            }
+        }
+
+        facearea.assign(maxlabel+1, std::map<unsigned int, double>());
+        for (unsigned int a = 0; a != projected.size(); ++a)
+        {
+            for (auto const& f : projected[a])
+            {
+                std::array<double, 3> const& p = f.second;
+                double A = std::sqrt(p[0]*p[0] + p[1]*p[1] + p[2]*p[2]);
+                facearea[a][f.first] = A;
+                facearea[f.first][a] = A;
+            }
+        }
+    };
+};
+
+#endif
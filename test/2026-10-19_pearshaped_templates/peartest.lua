@@ -0,0 +1,24 @@
+positionfile = "../test/2026-10-19_pearshaped_templates/pears.dat"
+readfile = "../test/2026-10-19_pearshaped_templates/read.lua"
+
+xmin = -5
+ymin = -5
+zmin = -5
+
+xmax = 5
+ymax = 5
+zmax = 5
+
+epsilon = 1e-6
+
+boundary = "periodic"
+
+xpbc = false 
+ypbc = false 
+zpbc = false 
+
+postprocessing = false
+
+savepoly = true
+savereduced = true
+savesurface = true